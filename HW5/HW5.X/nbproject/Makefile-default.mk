@@ -57,17 +57,17 @@ OBJECTDIR=build/${CND_CONF}/${IMAGE_TYPE}
 DISTDIR=dist/${CND_CONF}/${IMAGE_TYPE}
 
 # Source Files Quoted if spaced
-SOURCEFILES_QUOTED_IF_SPACED=ws2812b.c
+SOURCEFILES_QUOTED_IF_SPACED=ws2812b.c anim.c
 
 # Object Files Quoted if spaced
-OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/ws2812b.o
-POSSIBLE_DEPFILES=${OBJECTDIR}/ws2812b.o.d
+OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/ws2812b.o ${OBJECTDIR}/anim.o
+POSSIBLE_DEPFILES=${OBJECTDIR}/ws2812b.o.d ${OBJECTDIR}/anim.o.d
 
 # Object Files
-OBJECTFILES=${OBJECTDIR}/ws2812b.o
+OBJECTFILES=${OBJECTDIR}/ws2812b.o ${OBJECTDIR}/anim.o
 
 # Source Files
-SOURCEFILES=ws2812b.c
+SOURCEFILES=ws2812b.c anim.c
 
 
 
@@ -113,6 +113,12 @@ ${OBJECTDIR}/ws2812b.o: ws2812b.c  nbproject/Makefile-${CND_CONF}.mk
 	@${RM} ${OBJECTDIR}/ws2812b.o 
 	@${FIXDEPS} "${OBJECTDIR}/ws2812b.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG   -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/ws2812b.o.d" -o ${OBJECTDIR}/ws2812b.o ws2812b.c    -DXPRJ_default=$(CND_CONF)  -legacy-libc  $(COMPARISON_BUILD)  -mdfp=${DFP_DIR}  
 	
+${OBJECTDIR}/anim.o: anim.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/anim.o.d 
+	@${RM} ${OBJECTDIR}/anim.o 
+	@${FIXDEPS} "${OBJECTDIR}/anim.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG   -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/anim.o.d" -o ${OBJECTDIR}/anim.o anim.c    -DXPRJ_default=$(CND_CONF)  -legacy-libc  $(COMPARISON_BUILD)  -mdfp=${DFP_DIR}  
+	
 else
 ${OBJECTDIR}/ws2812b.o: ws2812b.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}" 
@@ -120,6 +126,12 @@ ${OBJECTDIR}/ws2812b.o: ws2812b.c  nbproject/Makefile-${CND_CONF}.mk
 	@${RM} ${OBJECTDIR}/ws2812b.o 
 	@${FIXDEPS} "${OBJECTDIR}/ws2812b.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/ws2812b.o.d" -o ${OBJECTDIR}/ws2812b.o ws2812b.c    -DXPRJ_default=$(CND_CONF)  -legacy-libc  $(COMPARISON_BUILD)  -mdfp=${DFP_DIR}  
 	
+${OBJECTDIR}/anim.o: anim.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/anim.o.d 
+	@${RM} ${OBJECTDIR}/anim.o 
+	@${FIXDEPS} "${OBJECTDIR}/anim.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/anim.o.d" -o ${OBJECTDIR}/anim.o anim.c    -DXPRJ_default=$(CND_CONF)  -legacy-libc  $(COMPARISON_BUILD)  -mdfp=${DFP_DIR}  
+	
 endif
 
 # ------------------------------------------------------------------------------------
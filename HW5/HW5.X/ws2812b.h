@@ -10,8 +10,39 @@ typedef struct {
     unsigned char b;
 } wsColor; 
 
+// 16 bit linear color for the output stage
+typedef struct {
+    unsigned short r;
+    unsigned short g;
+    unsigned short b;
+} wsColor16;
+
+#define WS2812B_MAX_LEDS 64 // most LEDs the buffered output modes can hold
+#define WS2812B_BYTES_PER_LED 3 // RAM per LED of ws2812b_setColor(), just the wsColor
+
 void ws2812b_setup();
-void ws2812b_setColor(wsColor*,int);
+int ws2812b_setColor(wsColor*,int); // 0 if the frame didn't change and wasn't sent
+void ws2812b_setRefresh(unsigned int ms); // resend an unchanged frame after ms, 0 to always send
+void ws2812b_invalidate(); // send the next frame even if it didn't change
+
+// compact frames, expanded to wire bits only while they are sent, any numLEDs
+#define WS2812B_PAL4_BYTES(n) (((n) + 1) / 2) // pixel bytes of a 4 bit frame
+int ws2812b_setColor565(const unsigned short * px, int numLEDs); // 2 bytes/LED, rrrrrggggggbbbbb
+int ws2812b_setColorPal8(const unsigned char * px, const wsColor * palette, int numLEDs); // 1 byte/LED, 256 colors
+int ws2812b_setColorPal4(const unsigned char * px, const wsColor * palette, int numLEDs); // 2 LEDs/byte, 16 colors, even LED in the low nibble
 wsColor HSBtoRGB(float hue, float sat, float brightness);
 
+// output stage: gamma, global brightness (0 to 256) and temporal dithering, then ws2812b_setColor()
+// The dither leftovers of every LED are kept between frames, for up to WS2812B_MAX_LEDS LEDs.
+// Longer frames aren't cut short, nothing is sent and they return WS2812B_TOO_MANY.
+#define WS2812B_TOO_MANY (-1)
+void ws2812b_setBrightness(unsigned short brightness);
+int ws2812b_show(wsColor * c, int numLEDs); // 1 if sent, 0 if unchanged, WS2812B_TOO_MANY
+int ws2812b_show16(wsColor16 * c, int numLEDs);
+
+// integer color wheel, hue 0 to HSB_HUE_MAX-1, sat and brightness 0 to 255
+#define HSB_HUE_MAX 1536 // 6 * 256
+wsColor HSBtoRGB_fixed(unsigned int hue, unsigned char sat, unsigned char brightness);
+void HSBtoRGB_rainbow(wsColor * c, int numLEDs, unsigned int hue, unsigned char sat, unsigned char brightness);
+
 #endif
\ No newline at end of file
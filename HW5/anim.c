@@ -0,0 +1,207 @@
+// LED animation engine, see anim.h
+
+#include "anim.h"
+#include <string.h> // for memset and memmove
+
+wsColor anim_frame[WS2812B_MAX_LEDS]; // the frame sent at the next tick, effects build on it
+wsColor anim_wheel[ANIM_WHEEL_SIZE]; // rainbow colors, built when the effect is picked
+
+int anim_numLEDs = 0;
+int anim_effect = ANIM_RAINBOW;
+unsigned int anim_hue = 0; // base color
+unsigned char anim_sat = 255;
+unsigned char anim_speed = 1;
+unsigned int anim_phase = 0; // where the effect is, its meaning depends on the effect
+unsigned char anim_level = 0; // last breathe brightness
+unsigned int anim_seed = 0x1234567; // sparkle random state, never 0
+
+unsigned int anim_period; // core timer ticks per frame
+unsigned int anim_last; // core timer at the start of the last frame slot
+unsigned int anim_compute_ticks = 0;
+unsigned int anim_send_ticks = 0;
+unsigned int anim_max_ticks = 0;
+unsigned int anim_late = 0;
+
+// xorshift, plenty random for sparkles
+static unsigned int anim_random() {
+    anim_seed ^= anim_seed << 13;
+    anim_seed ^= anim_seed >> 17;
+    anim_seed ^= anim_seed << 5;
+    return anim_seed;
+}
+
+// take ANIM_DECAY/256 of every color, the old frame becomes the tail
+static void anim_fade() {
+    int i;
+    for (i = 0; i < anim_numLEDs; i++) {
+        anim_frame[i].r = (anim_frame[i].r * ANIM_DECAY) >> 8;
+        anim_frame[i].g = (anim_frame[i].g * ANIM_DECAY) >> 8;
+        anim_frame[i].b = (anim_frame[i].b * ANIM_DECAY) >> 8;
+    }
+}
+
+// hue plus offset, wrapped on the color wheel
+static unsigned int anim_wrapHue(unsigned int hue) {
+    return hue % HSB_HUE_MAX;
+}
+
+void anim_setup(int numLEDs, unsigned int fps) {
+    if (numLEDs > WS2812B_MAX_LEDS) {
+        numLEDs = WS2812B_MAX_LEDS;
+    }
+    if (numLEDs < 1) {
+        numLEDs = 1;
+    }
+    if (fps < 1) {
+        fps = 1;
+    }
+    anim_numLEDs = numLEDs;
+    anim_period = 24000000 / fps; // core timer runs at 24MHz
+    anim_max_ticks = 0;
+    anim_late = 0;
+    anim_setEffect(ANIM_RAINBOW, 0, 255, 1);
+    anim_last = _CP0_GET_COUNT();
+}
+
+void anim_setEffect(int effect, unsigned int hue, unsigned char sat, unsigned char speed) {
+    int i;
+    unsigned int half;
+
+    anim_effect = effect;
+    anim_hue = anim_wrapHue(hue);
+    anim_sat = sat;
+    anim_speed = speed;
+    anim_phase = 0;
+    anim_level = 0;
+    memset(anim_frame, 0, sizeof(anim_frame));
+
+    switch (effect) {
+        case ANIM_RAINBOW:
+            // the only HSB conversions of the rainbow, the ticks just look colors up
+            for (i = 0; i < ANIM_WHEEL_SIZE; i++) {
+                anim_wheel[i] = HSBtoRGB_fixed(i * (HSB_HUE_MAX / ANIM_WHEEL_SIZE), sat, 255);
+            }
+            anim_phase = anim_hue / (HSB_HUE_MAX / ANIM_WHEEL_SIZE);
+            break;
+        case ANIM_GRADIENT:
+            // hue goes up a third of the wheel to the middle of the strip and back down,
+            // so rotating it has no seam
+            half = (anim_numLEDs + 1) / 2;
+            for (i = 0; i < anim_numLEDs; i++) {
+                unsigned int d = (i < half) ? i : anim_numLEDs - i;
+                anim_frame[i] = HSBtoRGB_fixed(anim_wrapHue(anim_hue + d * (HSB_HUE_MAX / 3) / half), sat, 255);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// work out the next frame from the one just sent
+static void anim_step() {
+    int i;
+    unsigned int step, pos;
+    wsColor c;
+
+    switch (anim_effect) {
+        case ANIM_RAINBOW:
+            // spread the whole wheel over the strip, 8.8 fixed point wheel positions
+            anim_phase = (anim_phase + anim_speed) & (ANIM_WHEEL_SIZE - 1);
+            step = (ANIM_WHEEL_SIZE << 8) / anim_numLEDs;
+            pos = anim_phase << 8;
+            for (i = 0; i < anim_numLEDs; i++) {
+                anim_frame[i] = anim_wheel[(pos >> 8) & (ANIM_WHEEL_SIZE - 1)];
+                pos += step;
+            }
+            break;
+        case ANIM_CHASE:
+            // the head moves speed/16 LEDs a frame, everything behind it fades
+            // a short strip can be lapped more than once a frame
+            anim_phase = (anim_phase + anim_speed) % (anim_numLEDs << 4);
+            anim_fade();
+            anim_frame[anim_phase >> 4] = HSBtoRGB_fixed(anim_hue, anim_sat, 255);
+            break;
+        case ANIM_BREATHE:
+            // triangle wave, up 0 to 255 and back in 512/speed frames
+            anim_phase = (anim_phase + anim_speed) & 0x1FF;
+            pos = (anim_phase > 255) ? 511 - anim_phase : anim_phase;
+            if (pos != anim_level) {
+                anim_level = pos;
+                c = HSBtoRGB_fixed(anim_hue, anim_sat, anim_level);
+                for (i = 0; i < anim_numLEDs; i++) {
+                    anim_frame[i] = c;
+                }
+            }
+            break;
+        case ANIM_SPARKLE:
+            // a new sparkle with a chance of speed/256 every frame, any hue
+            anim_fade();
+            if ((anim_random() & 0xFF) < anim_speed) {
+                i = anim_random() % anim_numLEDs;
+                anim_frame[i] = HSBtoRGB_fixed(anim_random() % HSB_HUE_MAX, anim_sat, 255);
+            }
+            break;
+        case ANIM_GRADIENT:
+            // move one LED every 256/speed frames, only the wrapped LED is copied around
+            anim_phase += anim_speed;
+            if (anim_phase >= 256) {
+                anim_phase -= 256;
+                c = anim_frame[anim_numLEDs - 1];
+                memmove(&anim_frame[1], &anim_frame[0], (anim_numLEDs - 1) * sizeof(wsColor));
+                anim_frame[0] = c;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+int anim_tick() {
+    unsigned int start, sent;
+    int late = 0;
+
+    // wait for this frame's slot
+    while (_CP0_GET_COUNT() - anim_last < anim_period) {
+        ;
+    }
+    anim_last += anim_period;
+
+    // send the frame computed last time first, so the LEDs change at a steady rate
+    start = _CP0_GET_COUNT();
+    ws2812b_show(anim_frame, anim_numLEDs);
+    sent = _CP0_GET_COUNT();
+    anim_step();
+    anim_send_ticks = sent - start;
+    anim_compute_ticks = _CP0_GET_COUNT() - sent;
+
+    if (anim_send_ticks + anim_compute_ticks > anim_max_ticks) {
+        anim_max_ticks = anim_send_ticks + anim_compute_ticks;
+    }
+    // ran past the next slot, skip the missed slots instead of rushing to catch up
+    if (_CP0_GET_COUNT() - anim_last >= anim_period) {
+        anim_last = _CP0_GET_COUNT();
+        anim_late++;
+        late = 1;
+    }
+    return late;
+}
+
+unsigned int anim_computeTicks() {
+    return anim_compute_ticks;
+}
+
+unsigned int anim_sendTicks() {
+    return anim_send_ticks;
+}
+
+unsigned int anim_maxFrameTicks() {
+    return anim_max_ticks;
+}
+
+unsigned int anim_frameTicks() {
+    return anim_period;
+}
+
+unsigned int anim_lateFrames() {
+    return anim_late;
+}
@@ -0,0 +1,38 @@
+#ifndef ANIM_H__
+#define ANIM_H__
+
+#include<xc.h> // processor SFR definitions
+#include "ws2812b.h"
+
+// LED animations on a fixed frame rate.
+// Every effect keeps the last frame in anim_frame and only changes what moved:
+// the rainbow looks up a color wheel built once, the chase and the sparkle fade
+// the old frame and draw the new heads, the breathe computes one color and copies it,
+// the gradient is computed once and then only rotated.
+//
+// anim_tick() waits for the next frame slot, runs the effect and sends the frame.
+// The compute and the send time of every frame are measured, so you can see how much
+// of the frame period (24000000/fps core timer ticks) is left for more LEDs or a higher fps.
+// A WS2812B takes 30us to send, 64 LEDs is ~2ms, 1/25 of a 50fps frame.
+
+#define ANIM_RAINBOW 0 // color wheel spread over the strip, turning
+#define ANIM_CHASE 1 // one dot running down the strip with a fading tail
+#define ANIM_BREATHE 2 // whole strip fading in and out
+#define ANIM_SPARKLE 3 // random dots that fade out
+#define ANIM_GRADIENT 4 // hue to hue+1/3 of the wheel across the strip, slowly rotating
+
+#define ANIM_WHEEL_SIZE 256 // colors in the rainbow wheel, HSB_HUE_MAX/6 hue steps each
+#define ANIM_DECAY 224 // how much of the chase and sparkle trail is left every frame, out of 256
+
+void anim_setup(int numLEDs, unsigned int fps);
+// hue 0 to HSB_HUE_MAX-1 and sat 0 to 255 are the base color, speed is how far the effect moves each frame
+void anim_setEffect(int effect, unsigned int hue, unsigned char sat, unsigned char speed);
+int anim_tick(void); // wait for the next frame and show it, returns 1 if the last frame ran late
+
+unsigned int anim_computeTicks(void); // core timer ticks the effect took last frame
+unsigned int anim_sendTicks(void); // core timer ticks ws2812b_show() took last frame
+unsigned int anim_maxFrameTicks(void); // most compute + send ticks of any frame so far
+unsigned int anim_frameTicks(void); // the frame period in core timer ticks
+unsigned int anim_lateFrames(void); // frames that didn't fit in the period
+
+#endif
@@ -1,12 +1,43 @@
 // WS2812B library
 
 #include "ws2812b.h"
+#include "anim.h"
 #include<sys/attribs.h>
 // other includes if necessary for debugging
 
 // Timer2 delay times, you can tune these if necessary
-#define LOWTIME 15 // number of 48MHz cycles to be low for 0.35uS
-#define HIGHTIME 65 // number of 48MHz cycles to be high for 1.65uS
+// a 0 is T0HTIME high and the rest of BITTIME low, a 1 is T1HTIME high and the rest low
+#define T0HTIME 19 // number of 48MHz cycles, 19/48MHz = 0.40uS
+#define T1HTIME 34 // number of 48MHz cycles, 34/48MHz = 0.71uS
+#define BITTIME 60 // a whole bit, 60/48MHz = 1.25uS
+#define WS2812B_JITTER 4 // Timer2 ticks an edge can be late, one TMR2 read of the polling loop
+#define WS2812B_RESET_US 50 // low time that latches the colors, use 280 for the newer WS2812B-V5
+#define WS2812B_RESET_TICKS (WS2812B_RESET_US * 48) // in Timer2 ticks
+
+// Check the timing against the WS2812B datasheet when it compiles, times in nS.
+// Every high and low has to stay inside its window, 150nS either side of the typical time,
+// even with its two edges WS2812B_JITTER apart the wrong way:
+// T0H 0.35uS, T0L 0.8uS, T1H 0.7uS, T1L 0.6uS. HW7/test/test_timing.c checks the real edges.
+#define WS_NS(ticks) ((ticks) * 1000 / 48)
+#define WS_OUTSIDE(ticks, typ) (WS_NS((ticks) - WS2812B_JITTER) < (typ) - 150 || WS_NS((ticks) + WS2812B_JITTER) > (typ) + 150)
+#if WS_OUTSIDE(T0HTIME, 350)
+#error "T0HTIME is outside the 0.35+-0.15uS T0H window"
+#endif
+#if WS_OUTSIDE(BITTIME - T0HTIME, 800)
+#error "BITTIME - T0HTIME is outside the 0.8+-0.15uS T0L window"
+#endif
+#if WS_OUTSIDE(T1HTIME, 700)
+#error "T1HTIME is outside the 0.7+-0.15uS T1H window"
+#endif
+#if WS_OUTSIDE(BITTIME - T1HTIME, 600)
+#error "BITTIME - T1HTIME is outside the 0.6+-0.15uS T1L window"
+#endif
+#if WS2812B_RESET_US < 50
+#error "the reset has to be at least 50uS low"
+#endif
+#if WS2812B_RESET_TICKS > 65535
+#error "the reset doesn't fit in the 16 bit Timer2"
+#endif
 
 //Initialize PIC32MX170F256B
 // DEVCFG0
@@ -65,46 +96,17 @@ int main() {
     __builtin_enable_interrupts();
     //Set up w2812b
     ws2812b_setup();
-    //Declare and initialize hue value
-    float hue = 0;
+    //Global brightness 0.1, applied after the gamma with dithering
+    ws2812b_setBrightness(26);
     int numLEDs = 4;
+    //Rainbow turning once every 256 frames, sat 0.5, at 50 frames/s
+    anim_setup(numLEDs, 50);
+    anim_setEffect(ANIM_RAINBOW, 0, 128, 1);
     while(1){
-        //Blink a LED(green)
-        LATAbits.LATA4 = 1;
-        //Declare color variables array
-        wsColor c[numLEDs];
-        //Calculate color variables
-        
-        c[0] = HSBtoRGB(hue, 0.5, 0.1);
-        if(hue + 100 <= 359){
-            c[1] = HSBtoRGB(hue + 100, 0.5, 0.1);
-        }else{
-            c[1] = HSBtoRGB(hue + 100 - 360, 0.5, 0.1);            
-        }
-        if(hue + 200 <= 359){
-            c[2] = HSBtoRGB(hue + 200, 0.5, 0.1);
-        }else{
-            c[2] = HSBtoRGB(hue + 200 - 360, 0.5, 0.1);            
-        }
-        if(hue + 300 <= 359){
-            c[3] = HSBtoRGB(hue + 300, 0.5, 0.1);
-        }else{
-            c[3] = HSBtoRGB(hue + 300 - 360, 0.5, 0.1);            
-        }   
-        //Set ws2812b color with 
-        ws2812b_setColor(&c, numLEDs);
-        //Increase the hue value to update the color of ws2812b in next loop.
-        if (hue==359){
-            hue = 0;            
-        }else{
-            hue = hue + 1;
-        }
-        //Blink a LED(green)       
-        _CP0_SET_COUNT(0);
-        while(_CP0_GET_COUNT() < 240000){}
-        LATAbits.LATA4 = 0;
-        _CP0_SET_COUNT(0);
-        while(_CP0_GET_COUNT() < 240000){}
+        //Wait for the next frame, send it and work out the one after
+        anim_tick();
+        //Blink a LED(green), toggles every frame
+        LATAbits.LATA4 = !LATAbits.LATA4;
     }
 }
 
@@ -120,89 +122,263 @@ void ws2812b_setup() {
     LATBbits.LATB6 = 0;
 }
 
-// build an array of high/low times from the color input array, then output the high/low bits
-void ws2812b_setColor(wsColor * c, int numLEDs) {
-    int i = 0; int j = 0; // for loops
-    int numBits = 2 * 3 * 8 * numLEDs; // the number of high/low bits to store, 2 per color bit
-    volatile unsigned int delay_times[2*3*8 * 5]; // I only gave you 5 WS2812B, adjust this if you get more somewhere
+// wait until Timer2 reaches t, the 16 bit difference keeps working when TMR2 wraps
+#define WAIT_TMR2(t) while ((short)(TMR2 - (t)) < 0) {}
+// pack the 3 colors of an LED into 24 bits, sent MSB first
+#define WS_PACK(c) (((unsigned int)(c).r << 16) | ((unsigned int)(c).g << 8) | (c).b)
 
-    // start at time at 0
-    delay_times[0] = 0;
-    
-    int nB = 1; // which high/low bit you are storing, 2 per color bit, 24 color bits per WS2812B
-    // loop through each WS2812B
-    for (i = 0; i < numLEDs; i++) {
-        // loop through each color bit, MSB(Most Significant Bit) first
-        for (j = 7; j >= 0; j--) {
-            // if the bit is a 1
-            if (c[i].r>>j & 1 == 1) {
-                // the high is longer
-                delay_times[nB] = delay_times[nB - 1] + HIGHTIME;
-                nB++;
-                delay_times[nB] = delay_times[nB - 1] + LOWTIME;
-                nB++;
-            } 
-            // if the bit is a 0
-            else {
-                // the low is longer
-                delay_times[nB] = delay_times[nB - 1] + LOWTIME;
-                nB++;
-                delay_times[nB] = delay_times[nB - 1] + HIGHTIME;
-                nB++;
+// Change detection: a hash of the last frame sent is kept, and a frame with the same
+// hash is not sent again, unless the refresh period has gone by since it was last sent.
+// The WS2812Bs hold their colors, so this only costs anything if noise corrupted a frame,
+// and the refresh puts that right.
+unsigned int ws_sent_hash = 0; // hash of the last frame sent
+int ws_sent_leds = 0; // numLEDs of the last frame sent
+unsigned int ws_sent_time = 0; // core timer when it was sent
+unsigned int ws_refresh_ticks = 24000000; // resend an unchanged frame after 1s
+int ws_sent_valid = 0; // 0 to send the next frame no matter what
+
+// FNV-1a of len bytes, continuing from h (2166136261 to start)
+static unsigned int ws_hash(unsigned int h, const void * data, int len) {
+    const unsigned char * p = (const unsigned char *) data;
+    int i;
+    for (i = 0; i < len; i++) {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    return h;
+}
+
+// resend an unchanged frame after ms, 0 to send every frame
+void ws2812b_setRefresh(unsigned int ms) {
+    ws_refresh_ticks = ms * 24000; // core timer runs at 24MHz
+}
+
+// the next frame is sent even if it didn't change
+void ws2812b_invalidate() {
+    ws_sent_valid = 0;
+}
+
+// Pixel formats: the frame is kept in whatever format the caller has and every LED is
+// expanded to its 24 wire bits only as it is sent, by a fetch function for the format.
+typedef struct {
+    const void * pixels;
+    const wsColor * palette;
+} wsFrame;
+typedef unsigned int (*wsFetch)(const wsFrame * f, int i); // WS_PACK bits of LED i
+
+static unsigned int ws_fetchColor(const wsFrame * f, int i) {
+    return WS_PACK(((const wsColor *) f->pixels)[i]);
+}
+
+// 5 and 6 bit colors are scaled to 8 bits by repeating their top bits
+static unsigned int ws_fetch565(const wsFrame * f, int i) {
+    unsigned int v = ((const unsigned short *) f->pixels)[i];
+    unsigned int r = (v >> 11) & 0x1F;
+    unsigned int g = (v >> 5) & 0x3F;
+    unsigned int b = v & 0x1F;
+    r = (r << 3) | (r >> 2);
+    g = (g << 2) | (g >> 4);
+    b = (b << 3) | (b >> 2);
+    return (r << 16) | (g << 8) | b;
+}
+
+static unsigned int ws_fetchPal8(const wsFrame * f, int i) {
+    return WS_PACK(f->palette[((const unsigned char *) f->pixels)[i]]);
+}
+
+// two LEDs a byte, the even LED in the low nibble
+static unsigned int ws_fetchPal4(const wsFrame * f, int i) {
+    unsigned char v = ((const unsigned char *) f->pixels)[i >> 1];
+    return WS_PACK(f->palette[(v >> ((i & 1) << 2)) & 0x0F]);
+}
+
+// output the high/low bits, fetching every LED from the frame just before it is sent.
+// The next edge time is worked out while waiting for the current one, so there is
+// no delay_times buffer: RAM use is only the frame itself and any numLEDs works.
+// The next LED is fetched during the long part of bit 23, 34 Timer2 ticks or more, which
+// is plenty for any of the fetch functions.
+// returns 1 if the frame was sent, 0 if hash is the same as the last frame's and it was skipped
+static int ws_stream(wsFetch fetch, const wsFrame * f, int numLEDs, unsigned int hash) {
+    int led = 0; // which WS2812B is being sent
+    int bit = 23; // which of its 24 color bits
+    unsigned int word; // color bits of this LED
+    unsigned int next = 0; // color bits of the next LED
+    unsigned short t = 0; // Timer2 time of the next edge
+    unsigned int now;
+
+    if (numLEDs <= 0) {
+        return 0;
+    }
+    hash = ws_hash(hash, &fetch, sizeof(fetch)); // same bytes in another format is another frame
+    now = _CP0_GET_COUNT();
+    if (ws_sent_valid && hash == ws_sent_hash && numLEDs == ws_sent_leds
+            && now - ws_sent_time < ws_refresh_ticks) {
+        return 0; // nothing changed, the LEDs already show it
+    }
+    ws_sent_hash = hash;
+    ws_sent_leds = numLEDs;
+    ws_sent_time = now;
+    ws_sent_valid = 1;
+    word = fetch(f, 0);
+
+    // start the timer, then turn on the pin for the first high/low. The other way round the
+    // first high is long by the time the TMR2 write takes, a 0 could be read as a 1
+    TMR2 = 0;
+    LATBbits.LATB6 = 1;
+    while (1) {
+        // if the bit is a 1 the high is longer, if it is a 0 the low is longer
+        if ((word >> bit) & 1) {
+            t += T1HTIME;
+            if (bit == 23 && led + 1 < numLEDs) {
+                next = fetch(f, led + 1); // plenty of time while the pin is high
             }
-        }
-        // do it again for green
-        c;
-        for (j = 7; j >= 0; j--) {
-            // if the bit is a 1
-            if (c[i].g>>j & 1 == 1) {
-                // the high is longer
-                delay_times[nB] = delay_times[nB - 1] + HIGHTIME;
-                nB++;
-                delay_times[nB] = delay_times[nB - 1] + LOWTIME;
-                nB++;
-            } 
-            // if the bit is a 0
-            else {
-                // the low is longer
-                delay_times[nB] = delay_times[nB - 1] + LOWTIME;
-                nB++;
-                delay_times[nB] = delay_times[nB - 1] + HIGHTIME;
-                nB++;
+            WAIT_TMR2(t);
+            LATBINV = 0b1000000; // invert B6
+            t += BITTIME - T1HTIME;
+        } else {
+            t += T0HTIME;
+            WAIT_TMR2(t);
+            LATBINV = 0b1000000; // invert B6
+            t += BITTIME - T0HTIME;
+            if (bit == 23 && led + 1 < numLEDs) {
+                next = fetch(f, led + 1); // plenty of time while the pin is low
             }
         }
-		// do it again for blue        
-        for (j = 7; j >= 0; j--) {
-            // if the bit is a 1
-            if (c[i].b>>j & 1 == 1) {
-                // the high is longer
-                delay_times[nB] = delay_times[nB - 1] + HIGHTIME;
-                nB++;
-                delay_times[nB] = delay_times[nB - 1] + LOWTIME;
-                nB++;
-            } 
-            // if the bit is a 0
-            else {
-                // the low is longer
-                delay_times[nB] = delay_times[nB - 1] + LOWTIME;
-                nB++;
-                delay_times[nB] = delay_times[nB - 1] + HIGHTIME;
-                nB++;
+        if (bit == 0) {
+            led++;
+            if (led == numLEDs) {
+                break; // the pin is already low after the last bit
             }
-        }         
-    }
-
-    // turn on the pin for the first high/low
-    LATBbits.LATB6 = 1;
-    TMR2 = 0; // start the timer
-    for (i = 1; i < numBits; i++) {
-        while (TMR2 < delay_times[i]) {
+            word = next;
+            bit = 23;
+        } else {
+            bit--;
         }
-        LATBINV = 0b1000000; // invert B6
+        WAIT_TMR2(t);
+        LATBINV = 0b1000000; // invert B6, start of the next bit
     }
     LATBbits.LATB6 = 0;
     TMR2 = 0;
-    while(TMR2 < 2400){} // wait 50uS, reset condition
+    while(TMR2 < WS2812B_RESET_TICKS){} // reset condition
+    return 1;
+}
+
+// 3 bytes per LED
+int ws2812b_setColor(wsColor * c, int numLEDs) {
+    wsFrame f = {c, 0};
+    return ws_stream(ws_fetchColor, &f, numLEDs, ws_hash(2166136261u, c, numLEDs * sizeof(wsColor)));
+}
+
+// 2 bytes per LED, rrrrrggggggbbbbb
+int ws2812b_setColor565(const unsigned short * px, int numLEDs) {
+    wsFrame f = {px, 0};
+    return ws_stream(ws_fetch565, &f, numLEDs, ws_hash(2166136261u, px, numLEDs * 2));
+}
+
+// 1 byte per LED, an index into a 256 color palette
+int ws2812b_setColorPal8(const unsigned char * px, const wsColor * palette, int numLEDs) {
+    wsFrame f = {px, palette};
+    unsigned int hash;
+    hash = ws_hash(2166136261u, px, numLEDs);
+    hash = ws_hash(hash, palette, 256 * sizeof(wsColor));
+    return ws_stream(ws_fetchPal8, &f, numLEDs, hash);
+}
+
+// half a byte per LED, an index into a 16 color palette
+int ws2812b_setColorPal4(const unsigned char * px, const wsColor * palette, int numLEDs) {
+    wsFrame f = {px, palette};
+    unsigned int hash;
+    hash = ws_hash(2166136261u, px, (numLEDs + 1) / 2);
+    hash = ws_hash(hash, palette, 16 * sizeof(wsColor));
+    return ws_stream(ws_fetchPal4, &f, numLEDs, hash);
+}
+
+// Output stage: gamma, global brightness and temporal dithering
+// Colors are made 16 bit (gamma LUT), scaled by the global brightness, and the part below
+// 8 bits is carried to the next frame per LED and color (error diffusion), so dim levels
+// average out to the right brightness over a few frames instead of being truncated.
+
+// (i/255)^2.2 * 65535
+static const unsigned short ws_gamma[256] = {
+        0,     0,     2,     4,     7,    11,    17,    24,
+       32,    42,    53,    65,    79,    94,   111,   129,
+      148,   169,   192,   216,   242,   270,   299,   330,
+      362,   396,   432,   469,   508,   549,   591,   635,
+      681,   729,   779,   830,   883,   938,   995,  1053,
+     1113,  1175,  1239,  1305,  1373,  1443,  1514,  1587,
+     1663,  1740,  1819,  1900,  1983,  2068,  2155,  2243,
+     2334,  2427,  2521,  2618,  2717,  2817,  2920,  3024,
+     3131,  3240,  3350,  3463,  3578,  3694,  3813,  3934,
+     4057,  4182,  4309,  4438,  4570,  4703,  4838,  4976,
+     5115,  5257,  5401,  5547,  5695,  5845,  5998,  6152,
+     6309,  6468,  6629,  6792,  6957,  7124,  7294,  7466,
+     7640,  7816,  7994,  8175,  8358,  8543,  8730,  8919,
+     9111,  9305,  9501,  9699,  9900, 10102, 10307, 10515,
+    10724, 10936, 11150, 11366, 11585, 11806, 12029, 12254,
+    12482, 12712, 12944, 13179, 13416, 13655, 13896, 14140,
+    14386, 14635, 14885, 15138, 15394, 15652, 15912, 16174,
+    16439, 16706, 16975, 17247, 17521, 17798, 18077, 18358,
+    18642, 18928, 19216, 19507, 19800, 20095, 20393, 20694,
+    20996, 21301, 21609, 21919, 22231, 22546, 22863, 23182,
+    23504, 23829, 24156, 24485, 24817, 25151, 25487, 25826,
+    26168, 26512, 26858, 27207, 27558, 27912, 28268, 28627,
+    28988, 29351, 29717, 30086, 30457, 30830, 31206, 31585,
+    31966, 32349, 32735, 33124, 33514, 33908, 34304, 34702,
+    35103, 35507, 35913, 36321, 36732, 37146, 37562, 37981,
+    38402, 38825, 39252, 39680, 40112, 40546, 40982, 41421,
+    41862, 42306, 42753, 43202, 43654, 44108, 44565, 45025,
+    45487, 45951, 46418, 46888, 47360, 47835, 48313, 48793,
+    49275, 49761, 50249, 50739, 51232, 51728, 52226, 52727,
+    53230, 53736, 54245, 54756, 55270, 55787, 56306, 56828,
+    57352, 57879, 58409, 58941, 59476, 60014, 60554, 61097,
+    61642, 62190, 62741, 63295, 63851, 64410, 64971, 65535
+};
+
+unsigned short ws_brightness = 256; // global brightness, 256 is full
+wsColor ws_out[WS2812B_MAX_LEDS]; // 8 bit colors sent this frame
+unsigned char ws_err[WS2812B_MAX_LEDS][3]; // what was left below 8 bits last frame
+
+// global brightness 0 to 256, applied after the gamma
+void ws2812b_setBrightness(unsigned short brightness) {
+    if (brightness > 256) {
+        brightness = 256;
+    }
+    ws_brightness = brightness;
+}
+
+// 16 bit linear color -> 8 bit, adding last frame's leftover of this LED and color
+static unsigned char ws_dither(unsigned short v, unsigned char * err) {
+    unsigned int x = ((v * ws_brightness) >> 8) + *err;
+    *err = x & 0xFF;
+    x = x >> 8;
+    return x > 255 ? 255 : x;
+}
+
+// send 16 bit linear colors through brightness and dithering, returns 1 if sent, see ws2812b.h
+int ws2812b_show16(wsColor16 * c, int numLEDs) {
+    int i;
+    if (numLEDs > WS2812B_MAX_LEDS) {
+        return WS2812B_TOO_MANY; // no dither state for the rest
+    }
+    for (i = 0; i < numLEDs; i++) {
+        ws_out[i].r = ws_dither(c[i].r, &ws_err[i][0]);
+        ws_out[i].g = ws_dither(c[i].g, &ws_err[i][1]);
+        ws_out[i].b = ws_dither(c[i].b, &ws_err[i][2]);
+    }
+    return ws2812b_setColor(ws_out, numLEDs);
+}
+
+// send 8 bit colors through the gamma LUT, brightness and dithering, returns 1 if sent, see ws2812b.h
+int ws2812b_show(wsColor * c, int numLEDs) {
+    int i;
+    if (numLEDs > WS2812B_MAX_LEDS) {
+        return WS2812B_TOO_MANY; // no dither state for the rest
+    }
+    for (i = 0; i < numLEDs; i++) {
+        ws_out[i].r = ws_dither(ws_gamma[c[i].r], &ws_err[i][0]);
+        ws_out[i].g = ws_dither(ws_gamma[c[i].g], &ws_err[i][1]);
+        ws_out[i].b = ws_dither(ws_gamma[c[i].b], &ws_err[i][2]);
+    }
+    return ws2812b_setColor(ws_out, numLEDs);
 }
 
 // adapted from https://forum.arduino.cc/index.php?topic=8498.0
@@ -278,4 +454,65 @@ wsColor HSBtoRGB(float hue, float sat, float brightness) {
     c.g = igreen;
     c.b = iblue;
     return c;
-}
\ No newline at end of file
+}
+
+// a*b/255 rounded to the nearest integer, without a division
+#define MUL255(a, b) ((((a)*(b) + 128) + ((((a)*(b) + 128)) >> 8)) >> 8)
+
+// integer version of HSBtoRGB(), no float math
+// hue is 0 to HSB_HUE_MAX-1, 256 steps for every 60 degrees of the color wheel
+// sat and brightness are 0 to 255
+wsColor HSBtoRGB_fixed(unsigned int hue, unsigned char sat, unsigned char brightness) {
+    wsColor c;
+    unsigned int slice = hue >> 8; // which 60 degrees
+    unsigned int frac = hue & 0xFF; // how far into it, out of 256
+    unsigned char aa = MUL255(brightness, 255 - sat);
+    unsigned char bb = MUL255(brightness, 255 - ((sat * frac) >> 8));
+    unsigned char cc = MUL255(brightness, 255 - ((sat * (256 - frac)) >> 8));
+
+    switch (slice) {
+        case 0:
+            c.r = brightness; c.g = cc; c.b = aa;
+            break;
+        case 1:
+            c.r = bb; c.g = brightness; c.b = aa;
+            break;
+        case 2:
+            c.r = aa; c.g = brightness; c.b = cc;
+            break;
+        case 3:
+            c.r = aa; c.g = bb; c.b = brightness;
+            break;
+        case 4:
+            c.r = cc; c.g = aa; c.b = brightness;
+            break;
+        case 5:
+            c.r = brightness; c.g = aa; c.b = bb;
+            break;
+        default:
+            c.r = 0; c.g = 0; c.b = 0;
+            break;
+    }
+    return c;
+}
+
+// fill the whole color array with a rainbow, the hues evenly spaced around the wheel
+// starting from hue (0 to HSB_HUE_MAX-1) at the first LED
+void HSBtoRGB_rainbow(wsColor * c, int numLEDs, unsigned int hue, unsigned char sat, unsigned char brightness) {
+    int i;
+    unsigned int step;
+    if (numLEDs <= 0) {
+        return;
+    }
+    step = HSB_HUE_MAX / numLEDs;
+    while (hue >= HSB_HUE_MAX) {
+        hue -= HSB_HUE_MAX;
+    }
+    for (i = 0; i < numLEDs; i++) {
+        c[i] = HSBtoRGB_fixed(hue, sat, brightness);
+        hue += step;
+        if (hue >= HSB_HUE_MAX) {
+            hue -= HSB_HUE_MAX;
+        }
+    }
+}
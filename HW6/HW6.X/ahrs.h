@@ -0,0 +1,40 @@
+#ifndef AHRS_H__
+#define AHRS_H__
+
+#include <xc.h>
+#include "imu.h" // for the gyro scale
+
+// Orientation from the gyro and the accelerometer, integer math only.
+// The orientation is a unit quaternion q0 + q1 i + q2 j + q3 k in Q30 (an int with 30
+// fraction bits, AHRS_ONE is 1.0). Every update turns it by the gyro rates over one sample
+// period, and the accelerometer pulls it back towards where gravity is measured, so the gyro
+// drift doesn't add up in roll and pitch:
+// AHRS_COMPLEMENTARY adds Kp times the error between measured and estimated gravity to the
+// rates (Mahony's form of the complementary filter),
+// AHRS_MADGWICK takes a gradient descent step of beta towards the measured gravity.
+// Products are 32x32->64 bit (one MULT each), and an update has one division to normalize the
+// accelerometer plus one more for Madgwick's step. Yaw has no reference and drifts.
+// An update has to fit in AHRS_BUDGET_CYCLES, AHRS_BENCHMARK in imu.c shows what it takes.
+// test/test_ahrs.c checks ahrs_atan2() and both filters on the PC, the filters against the same
+// equations in double on recordings of a moving board.
+
+#define AHRS_COMPLEMENTARY 0
+#define AHRS_MADGWICK 1
+
+#define AHRS_ONE (1 << 30) // 1.0 in Q30
+#define AHRS_KP 32768 // complementary gain in Q16, 0.5 rad/s per unit of gravity error
+#define AHRS_BETA 6554 // Madgwick gain in Q16, 0.1 rad/s
+#define AHRS_BUDGET_CYCLES 2000 // per update, 7% of the 28900 cycles between samples at 1.66kHz
+
+typedef struct {
+    int q0, q1, q2, q3; // Q30
+} ahrsQuat;
+
+void ahrs_setup(int algorithm, unsigned int rate); // rate in samples/s, starts level
+void ahrs_reset(void); // back to level, facing x
+void ahrs_update(int gx, int gy, int gz, int ax, int ay, int az); // raw gyro and accel LSB
+void ahrs_quaternion(ahrsQuat * q);
+void ahrs_euler(int * roll, int * pitch, int * yaw); // centidegrees, pitch -9000 to 9000
+int ahrs_atan2(int y, int x); // centidegrees, -18000 to 18000
+
+#endif
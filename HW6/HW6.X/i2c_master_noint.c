@@ -9,10 +9,49 @@
 void i2c_master_setup(void) {
     // using a large BRG to see it on the nScope, make it smaller after verifying that code works
     // look up TPGD in the datasheet
-    I2C1BRG = 100; // I2CBRG = [1/(2*Fsck) - TPGD]*Pblck - 2 (TPGD is the Pulse Gobbler Delay)
+    // 400kHz so an IMU sample (17 bytes) fits well inside the 600uS between samples at 1.66kHz
+    I2C1BRG = 53; // I2CBRG = [1/(2*Fsck) - TPGD]*Pblck - 2 (TPGD is the Pulse Gobbler Delay) = [1.25uS - 104nS]*48MHz - 2
     I2C1CONbits.ON = 1; // turn on the I2C1 module
 }
 
+// Bus lock
+// The ssd1306 and the IMU share I2C1, and the IMU is read from its data-ready interrupt.
+// Main code puts every transaction between i2c_master_lock() and i2c_master_unlock(), and an
+// interrupt that finds the bus locked leaves its transaction to i2c_master_unlock() instead
+// of breaking into the middle of the other one.
+volatile int i2c_master_locked = 0;
+void (* volatile i2c_master_deferred)(void) = 0; // transaction an interrupt left for unlock
+
+void i2c_master_lock(void) {
+    i2c_master_locked = 1;
+}
+
+// runs whatever an interrupt left while the bus was locked, then frees it. Main code only.
+void i2c_master_unlock(void) {
+    void (*fn)(void);
+    while (1) {
+        __builtin_disable_interrupts(); // nothing can be left between the check and the unlock
+        fn = i2c_master_deferred;
+        i2c_master_deferred = 0;
+        if (fn == 0) {
+            i2c_master_locked = 0;
+            __builtin_enable_interrupts();
+            return;
+        }
+        __builtin_enable_interrupts();
+        fn(); // the bus is still locked, another interrupt would leave its transaction again
+    }
+}
+
+// from an interrupt: run the transaction fn now if the bus is free, or at i2c_master_unlock()
+void i2c_master_run(void (*fn)(void)) {
+    if (i2c_master_locked) {
+        i2c_master_deferred = fn;
+    } else {
+        fn();
+    }
+}
+
 void i2c_master_start(void) {
     I2C1CONbits.SEN = 1; // send the start bit
     while (I2C1CONbits.SEN) {
@@ -14,6 +14,14 @@ unsigned char i2c_master_recv(void); // receive a byte of data
 void i2c_master_ack(int val); // send an ACK (0) or NACK (1)
 void i2c_master_stop(void); // send a stop
 
+// the bus is shared with interrupts, see i2c_master_noint.c
+void i2c_master_lock(void); // main code, before a transaction
+void i2c_master_unlock(void); // and after it
+void i2c_master_run(void (*fn)(void)); // interrupts, fn does one transaction
+
+void setPin(unsigned char address, unsigned char regist, unsigned char value); // write one register
+unsigned char readPin(unsigned char address, unsigned char regist); // read one register
+
 void i2c_master_read_multiple(unsigned char address, unsigned char regist, unsigned char * data, int len);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,256 @@
+// IMU calibration, see imucal.h
+
+#include "imucal.h"
+#include <sys/kmem.h> // KVA_TO_PA for the NVM addresses
+
+#define IMUCAL_WORDS (1 + 9 + 1) // magic, the 9 ints of imuCal, check
+#define IMUCAL_STILL_GYRO (IMUCAL_STILL_MDPS * 256 / IMU_G_MDPS_Q8) // in LSB
+#define IMUCAL_STILL_ACCEL (IMUCAL_STILL_MG * 65536 / IMU_XL_MG_Q16)
+
+// the flash page the calibration lives in, a whole page so erasing it erases nothing else
+const unsigned int imucal_page[IMUCAL_PAGE_BYTES / 4] __attribute__((aligned(IMUCAL_PAGE_BYTES))) = {0};
+
+imuCal imucal_active;
+int imucal_on = 0;
+int imucal_up[3]; // accel average with the axis pointing up (+1g)
+int imucal_down[3];
+int imucal_sides = 0;
+
+void imucal_default(imuCal * cal) {
+    int i;
+    for (i = 0; i < 3; i++) {
+        cal->gyro_bias[i] = 0;
+        cal->accel_offset[i] = 0;
+        cal->accel_scale[i] = 65536;
+    }
+}
+
+// the next sample, raw. Waits for both data-ready bits so no sample is counted twice
+static void imucal_next(imuRaw * s) {
+    unsigned char status;
+    do {
+        i2c_master_lock();
+        status = readPin(IMU_ADDR, IMU_STATUS_REG); // STATUS_REG(GDA bit 1, XLDA bit 0)
+        i2c_master_unlock();
+    } while ((status & 0b11) != 0b11);
+    imu_read(s);
+}
+
+// average IMUCAL_SAMPLES samples, returns 0 if any axis spread more than a still board does
+static int imucal_capture(int * gyro, int * accel) {
+    imuRaw s;
+    signed short * g = &s.gx;
+    signed short * a = &s.ax;
+    int gmin[3], gmax[3], amin[3], amax[3];
+    int i, k;
+    int still = 1;
+
+    for (k = 0; k < 3; k++) {
+        gyro[k] = 0;
+        accel[k] = 0;
+        gmin[k] = amin[k] = 32767;
+        gmax[k] = amax[k] = -32768;
+    }
+    for (i = 0; i < IMUCAL_SAMPLES; i++) {
+        imucal_next(&s);
+        for (k = 0; k < 3; k++) {
+            gyro[k] += g[k];
+            accel[k] += a[k];
+            if (g[k] < gmin[k]) {
+                gmin[k] = g[k];
+            }
+            if (g[k] > gmax[k]) {
+                gmax[k] = g[k];
+            }
+            if (a[k] < amin[k]) {
+                amin[k] = a[k];
+            }
+            if (a[k] > amax[k]) {
+                amax[k] = a[k];
+            }
+        }
+    }
+    for (k = 0; k < 3; k++) {
+        gyro[k] /= IMUCAL_SAMPLES;
+        accel[k] /= IMUCAL_SAMPLES;
+        if (gmax[k] - gmin[k] > IMUCAL_STILL_GYRO || amax[k] - amin[k] > IMUCAL_STILL_ACCEL) {
+            still = 0;
+        }
+    }
+    return still;
+}
+
+int imucal_gyro(imuCal * cal) {
+    int gyro[3], accel[3];
+    int k;
+    if (!imucal_capture(gyro, accel)) {
+        return 0;
+    }
+    for (k = 0; k < 3; k++) {
+        cal->gyro_bias[k] = gyro[k];
+    }
+    return 1;
+}
+
+void imucal_accelReset() {
+    imucal_sides = 0;
+}
+
+int imucal_accelSide() {
+    int gyro[3], accel[3];
+    int k, axis, side;
+    if (!imucal_capture(gyro, accel)) {
+        return -1;
+    }
+    // the axis gravity is on, it has to be close to vertical
+    axis = 0;
+    for (k = 1; k < 3; k++) {
+        if (accel[k] * accel[k] > accel[axis] * accel[axis]) {
+            axis = k;
+        }
+    }
+    if (accel[axis] < IMU_XL_1G * 4 / 5 && accel[axis] > -IMU_XL_1G * 4 / 5) {
+        return -1;
+    }
+    if (accel[axis] > 0) {
+        imucal_up[axis] = accel[axis];
+        side = 2 * axis;
+    } else {
+        imucal_down[axis] = accel[axis];
+        side = 2 * axis + 1;
+    }
+    imucal_sides |= 1 << side;
+    return side;
+}
+
+int imucal_accelSides() {
+    return imucal_sides;
+}
+
+int imucal_accelDone(imuCal * cal) {
+    int k;
+    if (imucal_sides != 0b111111) {
+        return 0;
+    }
+    for (k = 0; k < 3; k++) {
+        cal->accel_offset[k] = (imucal_up[k] + imucal_down[k]) / 2;
+        cal->accel_scale[k] = (2 * IMU_XL_1G * 65536LL) / (imucal_up[k] - imucal_down[k]);
+    }
+    return 1;
+}
+
+void imucal_use(const imuCal * cal) {
+    imucal_active = *cal;
+    imucal_on = 1;
+}
+
+// clip to a short
+static signed short imucal_sat(int x) {
+    if (x > 32767) {
+        return 32767;
+    }
+    if (x < -32768) {
+        return -32768;
+    }
+    return x;
+}
+
+void imucal_correct(signed short * gyro, signed short * accel) {
+    int k;
+    if (!imucal_on) {
+        return;
+    }
+    for (k = 0; k < 3; k++) {
+        gyro[k] = imucal_sat(gyro[k] - imucal_active.gyro_bias[k]);
+        accel[k] = imucal_sat(((long long) (accel[k] - imucal_active.accel_offset[k]) * imucal_active.accel_scale[k]) >> 16);
+    }
+}
+
+// the calibration as it is kept in flash, with a check word so a half written page doesn't count
+static void imucal_pack(const imuCal * cal, unsigned int * words) {
+    int k;
+    unsigned int sum = 0;
+    words[0] = IMUCAL_MAGIC;
+    for (k = 0; k < 3; k++) {
+        words[1 + k] = cal->gyro_bias[k];
+        words[4 + k] = cal->accel_offset[k];
+        words[7 + k] = cal->accel_scale[k];
+    }
+    for (k = 0; k < IMUCAL_WORDS - 1; k++) {
+        sum += words[k];
+    }
+    words[IMUCAL_WORDS - 1] = ~sum;
+}
+
+// the page through kseg1, uncached and not something the compiler can work out from the initializer
+static const volatile unsigned int * imucal_flash() {
+    return (const volatile unsigned int *) KVA0_TO_KVA1((unsigned int) imucal_page);
+}
+
+int imucal_load(imuCal * cal) {
+    const volatile unsigned int * flash = imucal_flash();
+    unsigned int words[IMUCAL_WORDS];
+    unsigned int check[IMUCAL_WORDS];
+    int k;
+    for (k = 0; k < IMUCAL_WORDS; k++) {
+        words[k] = flash[k];
+    }
+    if (words[0] != IMUCAL_MAGIC) {
+        return 0; // erased, or never saved
+    }
+    for (k = 0; k < 3; k++) {
+        cal->gyro_bias[k] = words[1 + k];
+        cal->accel_offset[k] = words[4 + k];
+        cal->accel_scale[k] = words[7 + k];
+    }
+    imucal_pack(cal, check);
+    return check[IMUCAL_WORDS - 1] == words[IMUCAL_WORDS - 1];
+}
+
+// one NVM operation (NVMOP), returns the WRERR and LVDERR bits, 0 when it worked
+static unsigned int imucal_nvm(unsigned int op) {
+    unsigned int status;
+    unsigned int start;
+
+    NVMCON = 0x4000 | op; // WREN + NVMOP
+    start = _CP0_GET_COUNT();
+    while (_CP0_GET_COUNT() - start < 144) {} // 6uS for the flash supply to settle
+
+    // the unlock sequence can't be interrupted
+    status = __builtin_disable_interrupts();
+    NVMKEY = 0xAA996655;
+    NVMKEY = 0x556699AA;
+    NVMCONSET = 0x8000; // WR
+    if (status & 1) {
+        __builtin_enable_interrupts();
+    }
+    while (NVMCON & 0x8000) {} // the CPU stalls on flash reads until it is done anyway
+
+    NVMCONCLR = 0x4000; // WREN off
+    return NVMCON & 0x3000;
+}
+
+int imucal_save(const imuCal * cal) {
+    const volatile unsigned int * flash = imucal_flash();
+    unsigned int words[IMUCAL_WORDS];
+    int k;
+
+    imucal_pack(cal, words);
+    NVMADDR = KVA_TO_PA(imucal_page);
+    if (imucal_nvm(0b0100)) { // page erase
+        return 0;
+    }
+    for (k = 0; k < IMUCAL_WORDS; k++) {
+        NVMADDR = KVA_TO_PA(&imucal_page[k]);
+        NVMDATA = words[k];
+        if (imucal_nvm(0b0001)) { // word program
+            return 0;
+        }
+    }
+    for (k = 0; k < IMUCAL_WORDS; k++) {
+        if (flash[k] != words[k]) {
+            return 0;
+        }
+    }
+    return 1;
+}
@@ -0,0 +1,41 @@
+#ifndef IMUCAL_H__
+#define IMUCAL_H__
+
+#include <xc.h>
+#include "imu.h"
+
+// IMU calibration, kept in flash so a reboot doesn't have to do it again.
+// The gyro bias is the average while the board is still. The accelerometer offset and scale
+// come from the board lying still on each of its 6 sides: with +1g and -1g measured on an
+// axis, the offset is halfway between them and the scale makes them exactly IMU_XL_1G apart
+// from 0. imucal_use() puts a calibration in the sample pipeline, imu_get() and
+// imu_fifo_read() samples come out corrected (a subtraction, and a multiply and shift).
+// The captures read the IMU directly, so calibrate before imu_drdy_start()/imu_fifo_start().
+// The calibration takes the one flash page of imucal_page, written through the NVM controller.
+
+#define IMUCAL_SAMPLES 512 // samples averaged per capture, about 0.3s
+#define IMUCAL_STILL_MDPS 3000 // gyro spread of a still capture
+#define IMUCAL_STILL_MG 50 // accel spread of a still capture
+#define IMUCAL_PAGE_BYTES 1024 // flash erase page of the PIC32MX170
+#define IMUCAL_MAGIC 0x494D5531 // "IMU1", first word of a saved calibration
+
+typedef struct {
+    int gyro_bias[3]; // LSB, taken off the gyro
+    int accel_offset[3]; // LSB, taken off the accel
+    int accel_scale[3]; // Q16, multiplies the accel after the offset
+} imuCal;
+
+void imucal_default(imuCal * cal); // no correction
+int imucal_gyro(imuCal * cal); // board still, returns 0 if it moved
+void imucal_accelReset(void); // forget the captured sides
+int imucal_accelSide(void); // board still on a side, returns the side 0-5 (x+ x- y+ y- z+ z-) or -1
+int imucal_accelSides(void); // bit per captured side, 0b111111 when all are in
+int imucal_accelDone(imuCal * cal); // offset and scale from the 6 sides, 0 if some are missing
+
+void imucal_use(const imuCal * cal); // correct the samples from here on
+void imucal_correct(signed short * gyro, signed short * accel); // x y z each, in place
+
+int imucal_load(imuCal * cal); // from flash, returns 0 if there is no valid calibration
+int imucal_save(const imuCal * cal); // to flash, returns 0 if the write or the check failed
+
+#endif
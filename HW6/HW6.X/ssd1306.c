@@ -44,11 +44,13 @@ void ssd1306_setup() {
 
 // send a command instruction (not pixel data)
 void ssd1306_command(unsigned char c) {
+    i2c_master_lock();
     i2c_master_start();
     i2c_master_send(ssd1306_write);
     i2c_master_send(0x00); // bit 7 is 0 for Co bit (data bytes only), bit 6 is 0 for DC (data is a command))
     i2c_master_send(c);
     i2c_master_stop();
+    i2c_master_unlock();
 }
 
 // update every pixel on the screen
@@ -62,14 +64,20 @@ void ssd1306_update() {
 
     unsigned short count = 512; // WIDTH * ((HEIGHT + 7) / 8)
     unsigned char * ptr = ssd1306_buffer; // first address of the pixel buffer
-    i2c_master_start();
-    i2c_master_send(ssd1306_write);
-    i2c_master_send(0x40); // send pixel data
-    // send every pixel
-    while (count--) {
-        i2c_master_send(*ptr++);
+    int i;
+    // send every pixel, a few at a time so the IMU can read between the pieces.
+    // The display keeps its column/page position from one data transaction to the next
+    while (count) {
+        i2c_master_lock();
+        i2c_master_start();
+        i2c_master_send(ssd1306_write);
+        i2c_master_send(0x40); // send pixel data
+        for (i = 0; i < SSD1306_CHUNK && count; i++, count--) {
+            i2c_master_send(*ptr++);
+        }
+        i2c_master_stop();
+        i2c_master_unlock();
     }
-    i2c_master_stop();
 }
 
 // set a pixel value. Call update() to push to the display)
@@ -93,6 +101,9 @@ void ssd1306_clear() {
 void drawLetter(unsigned char x, unsigned char y, char character){
     //Takes x and y as the position of the character
     //Draw a letter with x & y increase gradually
+    //Bytes 128-255 aren't in the table, they draw the fallback instead of reading past it
+    unsigned char code = (unsigned char) character;
+    const unsigned char *glyph = FONT_GLYPHS[code < 128 ? FONT_INDEX[code] : FONT_SLOT_FALLBACK];
     int j;
     int k;
     int scan_y;
@@ -100,7 +111,7 @@ void drawLetter(unsigned char x, unsigned char y, char character){
     for(j=0; j <= 4; j++){
         scan_y = y;
         for(k=0; k <= 7; k++){
-            color = (ASCII[character-0x20][j]>>k) & 1;
+            color = (glyph[j]>>k) & 1;
             ssd1306_drawPixel(x,scan_y,color);
             scan_y = scan_y + 1;
         }
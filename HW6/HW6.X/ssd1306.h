@@ -25,6 +25,10 @@
 #define SSD1306_SETSTARTLINE        0x40 
 #define SSD1306_DEACTIVATE_SCROLL   0x2E ///< Stop scroll
 
+// pixel bytes per I2C transaction in ssd1306_update(). An IMU sample read has to wait for
+// the one in progress, 4 bytes keep that wait around 160uS at 400kHz
+#define SSD1306_CHUNK 4
+
 void ssd1306_setup(void);
 void ssd1306_update(void);
 void ssd1306_clear(void);
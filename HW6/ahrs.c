@@ -0,0 +1,233 @@
+// orientation filters, see ahrs.h
+
+#include "ahrs.h"
+
+#define AHRS_PI_Q29 1686629713 // pi * 2^29
+
+int ahrs_algorithm = AHRS_COMPLEMENTARY;
+int ahrs_q[4] = {AHRS_ONE, 0, 0, 0};
+int ahrs_gyro_k = 0; // gyro LSB -> half the turn of one sample period, Q38
+int ahrs_kp_dt = 0; // Kp * dt / 2, Q30
+int ahrs_beta_dt = 0; // beta * dt, Q30
+
+// atan(2^-i) in centidegrees * 256, for the CORDIC in ahrs_atan2()
+const int ahrs_atan_table[16] = {
+    1152000, 680065, 359328, 182400, 91554, 45822, 22916, 11459,
+    5730, 2865, 1432, 716, 358, 179, 90, 45
+};
+
+// Q30 * Q30
+static int ahrs_mul(int a, int b) {
+    return ((long long) a * b) >> 30;
+}
+
+static unsigned int ahrs_isqrt(unsigned int x) {
+    unsigned int res = 0;
+    unsigned int bit = 1u << 30;
+    while (bit > x) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (x >= res + bit) {
+            x -= res + bit;
+            res = (res >> 1) + bit;
+        } else {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    return res;
+}
+
+// scale v to length 1 in Q30, returns 0 if it is all 0.
+// It is shifted to 15 bits first, so the squares add up in 32 bits and one 32 bit division does it
+static int ahrs_normalize(int * v, int n) {
+    int i, t;
+    int m = 0;
+    int shift = 0;
+    unsigned int sum = 0;
+    unsigned int r;
+
+    for (i = 0; i < n; i++) {
+        t = v[i] < 0 ? -v[i] : v[i];
+        if (t > m) {
+            m = t;
+        }
+    }
+    if (m == 0) {
+        return 0;
+    }
+    while (m >= (1 << 15)) {
+        m >>= 1;
+        shift++;
+    }
+    while (m < (1 << 14)) {
+        m <<= 1;
+        shift--;
+    }
+    for (i = 0; i < n; i++) {
+        t = shift >= 0 ? v[i] >> shift : v[i] << -shift;
+        v[i] = t;
+        sum += t * t; // under 2^30 each, 4 of them fit
+    }
+    r = AHRS_ONE / ahrs_isqrt(sum); // the length is 2^14 to 2^16
+    for (i = 0; i < n; i++) {
+        v[i] *= (int) r; // |v[i]| <= length, so under 2^30
+    }
+    return 1;
+}
+
+void ahrs_setup(int algorithm, unsigned int rate) {
+    if (rate < 1) {
+        rate = 1;
+    }
+    ahrs_algorithm = algorithm;
+    // half of LSB * mdps/1000 * pi/180 / rate, Q38 (IMU_G_MDPS_Q8 is mdps in Q8)
+    ahrs_gyro_k = (long long) IMU_G_MDPS_Q8 * AHRS_PI_Q29 * 2 / (360000LL * rate);
+    ahrs_kp_dt = ((long long) AHRS_KP << 13) / rate;
+    ahrs_beta_dt = ((long long) AHRS_BETA << 14) / rate;
+    ahrs_reset();
+}
+
+void ahrs_reset() {
+    ahrs_q[0] = AHRS_ONE;
+    ahrs_q[1] = 0;
+    ahrs_q[2] = 0;
+    ahrs_q[3] = 0;
+}
+
+void ahrs_update(int gx, int gy, int gz, int ax, int ay, int az) {
+    int * q = ahrs_q;
+    int h[3]; // half the turn of this sample, rad in Q30
+    int a[3];
+    int v[3];
+    int f[3];
+    int s[4];
+    int d[4];
+    int i, n, c;
+
+    h[0] = ((long long) gx * ahrs_gyro_k) >> 8;
+    h[1] = ((long long) gy * ahrs_gyro_k) >> 8;
+    h[2] = ((long long) gz * ahrs_gyro_k) >> 8;
+    s[0] = s[1] = s[2] = s[3] = 0;
+
+    a[0] = ax;
+    a[1] = ay;
+    a[2] = az;
+    if (ahrs_normalize(a, 3)) {
+        // where q says gravity is, in the sensor frame
+        v[0] = 2 * (ahrs_mul(q[1], q[3]) - ahrs_mul(q[0], q[2]));
+        v[1] = 2 * (ahrs_mul(q[0], q[1]) + ahrs_mul(q[2], q[3]));
+        v[2] = ahrs_mul(q[0], q[0]) - ahrs_mul(q[1], q[1]) - ahrs_mul(q[2], q[2]) + ahrs_mul(q[3], q[3]);
+
+        if (ahrs_algorithm == AHRS_MADGWICK) {
+            // gradient of |v - a|^2 over q, Madgwick's J^T f, in Q26 since it can reach 8.
+            // v - a reaches 2, which doesn't fit in Q30, so f is in Q29
+            f[0] = (v[0] >> 1) - (a[0] >> 1);
+            f[1] = (v[1] >> 1) - (a[1] >> 1);
+            f[2] = (v[2] >> 1) - (a[2] >> 1);
+            s[0] = (-(long long) q[2] * f[0] + (long long) q[1] * f[1]) >> 33;
+            s[1] = ((long long) q[3] * f[0] + (long long) q[0] * f[1] - 2 * (long long) q[1] * f[2]) >> 33;
+            s[2] = (-(long long) q[0] * f[0] + (long long) q[3] * f[1] - 2 * (long long) q[2] * f[2]) >> 33;
+            s[3] = ((long long) q[1] * f[0] + (long long) q[2] * f[1]) >> 33;
+            if (ahrs_normalize(s, 4)) {
+                for (i = 0; i < 4; i++) {
+                    s[i] = ahrs_mul(s[i], ahrs_beta_dt);
+                }
+            }
+        } else {
+            // a x v turns the estimate towards the measurement, add it to the rates
+            h[0] += ahrs_mul(ahrs_mul(a[1], v[2]) - ahrs_mul(a[2], v[1]), ahrs_kp_dt);
+            h[1] += ahrs_mul(ahrs_mul(a[2], v[0]) - ahrs_mul(a[0], v[2]), ahrs_kp_dt);
+            h[2] += ahrs_mul(ahrs_mul(a[0], v[1]) - ahrs_mul(a[1], v[0]), ahrs_kp_dt);
+        }
+    }
+
+    // q += q * (0, h) - s, the first order step of dq/dt = q * (0, w) / 2
+    d[0] = (-(long long) q[1] * h[0] - (long long) q[2] * h[1] - (long long) q[3] * h[2]) >> 30;
+    d[1] = ((long long) q[0] * h[0] + (long long) q[2] * h[2] - (long long) q[3] * h[1]) >> 30;
+    d[2] = ((long long) q[0] * h[1] - (long long) q[1] * h[2] + (long long) q[3] * h[0]) >> 30;
+    d[3] = ((long long) q[0] * h[2] + (long long) q[1] * h[1] - (long long) q[2] * h[0]) >> 30;
+    for (i = 0; i < 4; i++) {
+        q[i] += d[i] - s[i];
+    }
+
+    // back to length 1. It is close already, so one Newton step of 1/sqrt does it: q *= (3 - |q|^2) / 2
+    n = ((long long) q[0] * q[0] + (long long) q[1] * q[1] + (long long) q[2] * q[2] + (long long) q[3] * q[3]) >> 30;
+    c = (3 * (AHRS_ONE >> 1)) - (n >> 1);
+    for (i = 0; i < 4; i++) {
+        q[i] = ahrs_mul(q[i], c);
+    }
+}
+
+void ahrs_quaternion(ahrsQuat * q) {
+    q->q0 = ahrs_q[0];
+    q->q1 = ahrs_q[1];
+    q->q2 = ahrs_q[2];
+    q->q3 = ahrs_q[3];
+}
+
+// CORDIC: rotate (x, y) onto the x axis by +-atan(2^-i) steps, adding up the angle
+int ahrs_atan2(int y, int x) {
+    int z = 0;
+    int i, t, shift;
+    unsigned int ax, ay;
+
+    if (x == 0 && y == 0) {
+        return 0;
+    }
+    // scale so the larger of |x| and |y| is 2^28 to 2^29. Small inputs get all 16 steps worth
+    // of bits, and the length times the CORDIC gain of 1.65 still fits: 2^29 * 1.42 * 1.65 < 2^31
+    ax = x < 0 ? 0u - x : x;
+    ay = y < 0 ? 0u - y : y;
+    shift = __builtin_clz(ax > ay ? ax : ay) - 3;
+    if (shift > 0) {
+        x <<= shift;
+        y <<= shift;
+    } else {
+        x >>= -shift;
+        y >>= -shift;
+    }
+    if (x < 0) {
+        // turn by 180 degrees, the steps only reach +-99 degrees
+        z = (y >= 0) ? 18000 * 256 : -18000 * 256;
+        x = -x;
+        y = -y;
+    }
+    for (i = 0; i < 16; i++) {
+        t = x;
+        if (y > 0) {
+            x += y >> i;
+            y -= t >> i;
+            z += ahrs_atan_table[i];
+        } else {
+            x -= y >> i;
+            y += t >> i;
+            z -= ahrs_atan_table[i];
+        }
+    }
+    z = (z + 128) >> 8;
+    if (z > 18000) {
+        z -= 36000;
+    }
+    if (z < -18000) {
+        z += 36000;
+    }
+    return z;
+}
+
+void ahrs_euler(int * roll, int * pitch, int * yaw) {
+    int * q = ahrs_q;
+    int gx, gy, gz, c;
+
+    // gravity in the sensor frame again, roll and pitch are its direction
+    gx = 2 * (ahrs_mul(q[1], q[3]) - ahrs_mul(q[0], q[2]));
+    gy = 2 * (ahrs_mul(q[0], q[1]) + ahrs_mul(q[2], q[3]));
+    gz = ahrs_mul(q[0], q[0]) - ahrs_mul(q[1], q[1]) - ahrs_mul(q[2], q[2]) + ahrs_mul(q[3], q[3]);
+    *roll = ahrs_atan2(gy, gz);
+    // asin(-gx) as an atan2, the length of (gy, gz) in Q15 is plenty
+    c = ahrs_isqrt((unsigned int) ((gy >> 15) * (gy >> 15)) + (unsigned int) ((gz >> 15) * (gz >> 15)));
+    *pitch = ahrs_atan2(-gx, c << 15);
+    *yaw = ahrs_atan2(2 * (ahrs_mul(q[0], q[3]) + ahrs_mul(q[1], q[2])),
+            AHRS_ONE - 2 * (ahrs_mul(q[2], q[2]) + ahrs_mul(q[3], q[3])));
+}
@@ -3,6 +3,8 @@
 #include <string.h> // for memset
 #include "ssd1306.h"
 #include "font.h"
+#include "ahrs.h"
+#include "imucal.h"
 
 // DEVCFG0
 #pragma config DEBUG = OFF // disable debugging
@@ -37,6 +39,12 @@
 
 //unsigned char readPin(unsigned char address, unsigned char regist);
 
+#define IMU_FIFO_MODE 1 // 1 burst reads from the IMU FIFO, 0 one read per data-ready interrupt
+#define IMU_FIFO_BATCH 32 // samples per FIFO burst
+#define IMU_RATE 1660 // samples per second, the ODR of imu_setup()
+#define IMUCAL_FORCE 0 // 1 to calibrate again at boot even if flash has a calibration
+#define AHRS_BENCHMARK 0 // 1 to show the cycles per update of both orientation filters at startup
+
 int main() {
 
     __builtin_disable_interrupts(); // disable interrupts while initializing things
@@ -66,37 +74,127 @@ int main() {
     //Initialize ssd1306 communication
     ssd1306_setup();
     
-    //Declare data array
-    //2 bytes each for a_x, a_y, a_z, omega_x, omega_y, omega_z, temp 2*14 bytes = 2*14*8 bits
-    int len = 7;
-    signed short data_IMU[len];
+    char message[200];   
+    int i;
+    int roll = 0, pitch = 0, yaw = 0;
+
+    if (AHRS_BENCHMARK) {
+        // 1000 updates of each, tilted and turning, the core timer counts every 2 cycles
+        unsigned int start;
+        unsigned int cycles[2];
+        int alg;
+        for (alg = AHRS_COMPLEMENTARY; alg <= AHRS_MADGWICK; alg++) {
+            ahrs_setup(alg, IMU_RATE);
+            start = _CP0_GET_COUNT();
+            for (i = 0; i < 1000; i++) {
+                ahrs_update(300, -200, 100, 4000, -3000, 15600);
+            }
+            cycles[alg] = (_CP0_GET_COUNT() - start) * 2 / 1000;
+        }
+        start = _CP0_GET_COUNT();
+        ahrs_euler(&roll, &pitch, &yaw);
+        sprintf(message, "euler %d cyc", (_CP0_GET_COUNT() - start) * 2);
+        drawMessage(0, 16, message);
+        sprintf(message, "compl %d cyc", cycles[AHRS_COMPLEMENTARY]);
+        drawMessage(0, 0, message);
+        sprintf(message, "madgw %d cyc", cycles[AHRS_MADGWICK]);
+        drawMessage(0, 8, message);
+        sprintf(message, "budget %d cyc", AHRS_BUDGET_CYCLES);
+        drawMessage(0, 24, message);
+        ssd1306_update();
+        start = _CP0_GET_COUNT();
+        while (_CP0_GET_COUNT() - start < 24000000 * 3) {} // show it for 3s
+        ssd1306_clear();
+    }
+
+    //Calibration from flash, or a new one the first time
+    imuCal cal;
+    if (IMUCAL_FORCE || !imucal_load(&cal)) {
+        imucal_default(&cal);
+        drawMessage(0, 0, "calibrating, keep still");
+        ssd1306_update();
+        while (!imucal_gyro(&cal)) {}
+        imucal_accelReset();
+        while (!imucal_accelDone(&cal)) {
+            ssd1306_clear();
+            drawMessage(0, 0, "put it still on");
+            sprintf(message, "each side: %s%s%s%s%s%s",
+                    (imucal_accelSides() & 0b000001) ? "" : "x+ ", (imucal_accelSides() & 0b000010) ? "" : "x- ",
+                    (imucal_accelSides() & 0b000100) ? "" : "y+ ", (imucal_accelSides() & 0b001000) ? "" : "y- ",
+                    (imucal_accelSides() & 0b010000) ? "" : "z+ ", (imucal_accelSides() & 0b100000) ? "" : "z- ");
+            drawMessage(0, 8, message);
+            ssd1306_update();
+            imucal_accelSide();
+        }
+        if (!imucal_save(&cal)) {
+            drawMessage(0, 24, "flash write failed");
+            ssd1306_update();
+        }
+        ssd1306_clear();
+    }
+    imucal_use(&cal);
+
+    //Orientation from every sample
+    ahrs_setup(AHRS_COMPLEMENTARY, IMU_RATE);
+
+    //Read every sample the IMU makes in the background
+    imuSample sample = {0};
+#if IMU_FIFO_MODE
+    imuFifoSample batch[IMU_FIFO_BATCH];
+    int n;
+    imu_fifo_start(IMU_FIFO_BATCH);
+#else
+    imu_drdy_start();
+#endif
     
 //    unsigned char ssd1306_write = 0b01111000; // 0111100 i2c address unique address of ssd1306
 //    unsigned char ssd1306_read = 0b01111001; //   
 //    unsigned char ssd1306_buffer[512]; // 128x32/8. Every bit is a pixel  
-    char message[200];   
        
     while (1) {
         
         LATAbits.LATA4 = !LATAbits.LATA4; 
 
-        imu_read(IMU_OUT_TEMP_L, data_IMU, len);        
+        //Everything that came in since the last frame, the newest one is drawn
+#if IMU_FIFO_MODE
+        while (imu_fifo_ready()) {
+            n = imu_fifo_read(batch, IMU_FIFO_BATCH);
+            for (i = 0; i < n; i++) {
+                ahrs_update(batch[i].gx, batch[i].gy, batch[i].gz, batch[i].ax, batch[i].ay, batch[i].az);
+            }
+            if (n > 0) {
+                //no temperature in the FIFO, it stays 0 (25C)
+                sample.raw.gx = batch[n - 1].gx;
+                sample.raw.gy = batch[n - 1].gy;
+                sample.raw.gz = batch[n - 1].gz;
+                sample.raw.ax = batch[n - 1].ax;
+                sample.raw.ay = batch[n - 1].ay;
+                sample.raw.az = batch[n - 1].az;
+            }
+        }
+#else
+        while (imu_get(&sample)) {
+            ahrs_update(sample.raw.gx, sample.raw.gy, sample.raw.gz, sample.raw.ax, sample.raw.ay, sample.raw.az);
+        }
+#endif
+        ahrs_euler(&roll, &pitch, &yaw);
         
         if(0){
-            sprintf(message, "g: %d %d %d  ", data_IMU[1], data_IMU[2], data_IMU[3]);
+            sprintf(message, "dps: %d %d %d  ", IMU_GYRO_MDPS(sample.raw.gx) / 1000, IMU_GYRO_MDPS(sample.raw.gy) / 1000, IMU_GYRO_MDPS(sample.raw.gz) / 1000);
             drawMessage(0, 0, message);
-            sprintf(message, "a: %d %d %d  ", data_IMU[4], data_IMU[5], data_IMU[6]);
+            sprintf(message, "mg: %d %d %d  ", IMU_ACCEL_MG(sample.raw.ax), IMU_ACCEL_MG(sample.raw.ay), IMU_ACCEL_MG(sample.raw.az));
             drawMessage(0, 8, message);
-            sprintf(message, "t: %d  ", data_IMU[0]);
+            sprintf(message, "t: %d lost: %u  ", IMU_TEMP_CENTI(sample.raw.temp) / 100, IMU_FIFO_MODE ? imu_fifo_overruns() : imu_overflows());
             drawMessage(0, 16, message);                                     
+            sprintf(message, "r: %d p: %d y: %d  ", roll / 100, pitch / 100, yaw / 100);
+            drawMessage(0, 24, message);                                     
         }else{
-            bar_x(-data_IMU[5],1);
-            bar_y(data_IMU[4], 1);
+            //Tilt from the filter, the bars take 500 per pixel and 90 degrees is their 16 pixels
+            bar_x(-roll * 500 / 562, 1);
+            bar_y(-pitch * 500 / 562, 1);
         }
+        //No wait, the IMU reads in between the pieces of the update
         ssd1306_update();        
-              
-        _CP0_SET_COUNT(0);
-        while(_CP0_GET_COUNT() < 240000){}              
     }
 }
 
@@ -120,27 +218,232 @@ void imu_setup(){
         while(_CP0_GET_COUNT() < 24000000/2){}        
         }
     }
-    // init IMU_CTRL1_XL(accelerometer)(1.66kHz 1000 + 2g 00+ 100Hz filter 10)
-    setPin(IMU_ADDR, IMU_CTRL1_XL, 0b10000010);
-    // init IMU_CTRL2_G(gyroscope)(1.66kHz 1000 + 1000dps 10+ Default 00)
-    setPin(IMU_ADDR, IMU_CTRL2_G, 0b10001000);
-    // init IMU_CTRL3_C(IF_INC=1/0 enable/disable)
-    setPin(IMU_ADDR, IMU_CTRL3_C, 0b00000100);
+    // init IMU_CTRL1_XL(accelerometer)(1.66kHz 1000 + IMU_XL_FS_G + 100Hz filter 10)
+    setPin(IMU_ADDR, IMU_CTRL1_XL, 0b10000010 | (IMU_XL_FS_BITS << 2));
+    // init IMU_CTRL2_G(gyroscope)(1.66kHz 1000 + IMU_G_FS_DPS + Default 00)
+    setPin(IMU_ADDR, IMU_CTRL2_G, 0b10000000 | (IMU_G_FS_BITS << 2));
+    // init IMU_CTRL3_C(BDU=1 low and high bytes from the same sample + IF_INC=1/0 enable/disable)
+    setPin(IMU_ADDR, IMU_CTRL3_C, 0b01000100);
 }
 
-void imu_read(unsigned char regist, signed short * data_IMU, int len){
-    volatile unsigned char raw_data[len*2];
-    // read multiple from the imu, each data takes 2 reads so you need len*2 chars
-    i2c_master_read_multiple(0b1101011, regist, raw_data, len*2);
-    // turn the chars into the shorts
-    int i;
-    signed short p;
-    for(i=0;i<7;i++){       
-        p = raw_data[2*i+1];
-        p = p<<8;
-        p = p|raw_data[2*i];
-        data_IMU[i] = p; 
-    } 
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "imuRaw and imuFifoSample take the IMU bytes as they come, little endian"
+#endif
+// imuRaw is read as 14 bytes
+typedef char imu_raw_size_check[(sizeof(imuRaw) == 14) ? 1 : -1];
+
+// the burst read itself, the caller has the bus
+static void imu_readBus(imuRaw * raw){
+    i2c_master_read_multiple(IMU_ADDR, IMU_OUT_TEMP_L, (unsigned char *) raw, sizeof(imuRaw));
+}
+
+void imu_read(imuRaw * raw){
+    i2c_master_lock();
+    imu_readBus(raw);
+    i2c_master_unlock();
+}
+
+volatile imuSample imu_ring[IMU_RING_SIZE];
+volatile unsigned int imu_ring_head = 0; // written by imu_sample()
+volatile unsigned int imu_ring_tail = 0; // written by imu_get()
+volatile unsigned int imu_ring_overflows = 0;
+volatile unsigned int imu_drdy_time = 0; // core timer at the last data-ready edge
+
+// one sample into the ring, the transaction the data-ready interrupt runs or leaves for
+// i2c_master_unlock(). Reading it lets the INT1 line go low for the next edge.
+static void imu_sample(void){
+    unsigned int head = imu_ring_head;
+    imuSample * s;
+    imuRaw discard;
+    if (head - imu_ring_tail < IMU_RING_SIZE){
+        s = (imuSample *) &imu_ring[head & (IMU_RING_SIZE - 1)]; // imu_get() leaves this slot alone
+        s->time = imu_drdy_time;
+        imu_readBus(&s->raw);
+        imucal_correct(&s->raw.gx, &s->raw.ax);
+        imu_ring_head = head + 1;
+    }else{
+        imu_readBus(&discard); // still has to be read for the next edge
+        imu_ring_overflows++;
+    }
+}
+
+volatile int imu_fifo_on = 0; // INT1 is the FIFO watermark instead of data-ready
+volatile int imu_fifo_flag = 0; // set by the watermark edge, cleared by imu_fifo_read()
+int imu_fifo_watermark = 0; // samples
+unsigned int imu_fifo_overrun_count = 0;
+
+void __ISR(_EXTERNAL_1_VECTOR, IPL2SOFT) imu_int1_isr(void){
+    // INT1 stays high until the sample is read, so there is no new edge before a late
+    // read and the time is still the one of this sample
+    imu_drdy_time = _CP0_GET_COUNT();
+    IFS0bits.INT1IF = 0;
+    if (imu_fifo_on){
+        imu_fifo_flag = 1; // the burst is too long for an interrupt
+    }else{
+        i2c_master_run(imu_sample);
+    }
+}
+
+// the IMU INT1 pin to the PIC32 INT1 external interrupt, left off
+static void imu_int1_setup(void){
+    IEC0bits.INT1IE = 0;
+    ANSELBbits.ANSB14 = 0; // B14 is also AN10
+    TRISBbits.TRISB14 = 1;
+    INT1Rbits.INT1R = 0b0001; // INT1 on RPB14
+    INTCONbits.INT1EP = 1; // rising edge
+    IPC1bits.INT1IP = 2; // same as IPL2SOFT in the ISR
+    IPC1bits.INT1IS = 0;
+    IFS0bits.INT1IF = 0;
+}
+
+void imu_drdy_start(){
+    imuRaw discard;
+    imu_fifo_stop();
+    imu_int1_setup();
+    imu_ring_head = 0;
+    imu_ring_tail = 0;
+    imu_ring_overflows = 0;
+
+    i2c_master_lock();
+    // INT1_CTRL(INT1_DRDY_XL=1 accelerometer data-ready on INT1)
+    setPin(IMU_ADDR, IMU_INT1_CTRL, 0b00000001);
+    // INT1 might already be high with a sample nobody read, it would never make an edge.
+    // Read it away, an edge from here on is a new sample
+    IFS0bits.INT1IF = 0;
+    imu_readBus(&discard);
+    IEC0bits.INT1IE = 1;
+    i2c_master_unlock();
+}
+
+void imu_drdy_stop(){
+    if (imu_fifo_on){
+        return; // INT1 belongs to the FIFO
+    }
+    IEC0bits.INT1IE = 0;
+    i2c_master_lock();
+    setPin(IMU_ADDR, IMU_INT1_CTRL, 0b00000000);
+    i2c_master_unlock();
+    IFS0bits.INT1IF = 0;
+}
+
+int imu_available(){
+    return imu_ring_head - imu_ring_tail;
+}
+
+int imu_get(imuSample * sample){
+    unsigned int tail = imu_ring_tail;
+    if (tail == imu_ring_head){
+        return 0;
+    }
+    *sample = *(imuSample *) &imu_ring[tail & (IMU_RING_SIZE - 1)];
+    imu_ring_tail = tail + 1; // frees the slot for imu_sample()
+    return 1;
+}
+
+unsigned int imu_overflows(){
+    return imu_ring_overflows;
+}
+
+void imu_fifo_start(int watermark){
+    int words;
+    if (watermark < 1){
+        watermark = 1;
+    }
+    if (watermark > IMU_FIFO_MAX_WATERMARK){
+        watermark = IMU_FIFO_MAX_WATERMARK;
+    }
+    imu_drdy_stop();
+    imu_int1_setup();
+    imu_fifo_watermark = watermark;
+    imu_fifo_overrun_count = 0;
+    imu_fifo_flag = 0;
+    imu_fifo_on = 1;
+    words = watermark * IMU_FIFO_WORDS;
+
+    i2c_master_lock();
+    // FIFO_CTRL5(bypass mode 000) empties the FIFO
+    setPin(IMU_ADDR, IMU_FIFO_CTRL5, 0b00000000);
+    // FIFO_CTRL1/2(FTH watermark in words, 12 bits)
+    setPin(IMU_ADDR, IMU_FIFO_CTRL1, words & 0xFF);
+    setPin(IMU_ADDR, IMU_FIFO_CTRL2, (words >> 8) & 0x0F);
+    // FIFO_CTRL3(gyro no decimation 001 + accel no decimation 001)
+    setPin(IMU_ADDR, IMU_FIFO_CTRL3, 0b00001001);
+    // FIFO_CTRL4(no data sets 3 and 4)
+    setPin(IMU_ADDR, IMU_FIFO_CTRL4, 0b00000000);
+    // FIFO_CTRL5(FIFO ODR 1.66kHz 1000 like the sensors + continuous mode 110)
+    setPin(IMU_ADDR, IMU_FIFO_CTRL5, 0b01000110);
+    // INT1_CTRL(INT1_FTH=1 FIFO watermark on INT1), the FIFO is empty so INT1 is low
+    setPin(IMU_ADDR, IMU_INT1_CTRL, 0b00001000);
+    IEC0bits.INT1IE = 1;
+    i2c_master_unlock();
+}
+
+void imu_fifo_stop(){
+    if (!imu_fifo_on){
+        return;
+    }
+    IEC0bits.INT1IE = 0;
+    i2c_master_lock();
+    setPin(IMU_ADDR, IMU_INT1_CTRL, 0b00000000);
+    setPin(IMU_ADDR, IMU_FIFO_CTRL5, 0b00000000); // bypass
+    i2c_master_unlock();
+    IFS0bits.INT1IF = 0;
+    imu_fifo_on = 0;
+    imu_fifo_flag = 0;
+}
+
+int imu_fifo_ready(){
+    return imu_fifo_flag;
+}
+
+int imu_fifo_read(imuFifoSample * out, int max){
+    unsigned char status[4];
+    unsigned char skip[2];
+    int words, pattern, n, i;
+    if (!imu_fifo_on){
+        return 0;
+    }
+    imu_fifo_flag = 0; // a new edge from here on sets it again
+
+    i2c_master_lock();
+    // FIFO_STATUS1-4: unread words, flags, and which word of a sample comes next
+    i2c_master_read_multiple(IMU_ADDR, IMU_FIFO_STATUS1, status, 4);
+    words = ((status[1] & 0x0F) << 8) | status[0];
+    pattern = ((status[3] & 0x03) << 8) | status[2];
+    if (status[1] & 0b01000000){ // FIFO_OVER
+        imu_fifo_overrun_count++;
+        if (words == 0){
+            words = 4096; // 12 bits of DIFF_FIFO wrap when all 4096 words are full
+        }
+    }
+    // after an overrun the oldest word can be in the middle of a sample, skip to a gyro x
+    while (pattern != 0 && words > 0){
+        i2c_master_read_multiple(IMU_ADDR, IMU_FIFO_DATA_OUT_L, skip, 2);
+        words--;
+        pattern = (pattern + 1) % IMU_FIFO_WORDS;
+    }
+    n = words / IMU_FIFO_WORDS;
+    if (n > max){
+        n = max;
+    }
+    if (n > 0){
+        // the address goes back to FIFO_DATA_OUT_L after FIFO_DATA_OUT_H, one burst reads it all
+        i2c_master_read_multiple(IMU_ADDR, IMU_FIFO_DATA_OUT_L, (unsigned char *) out, n * sizeof(imuFifoSample));
+    }
+    i2c_master_unlock();
+    for (i = 0; i < n; i++){
+        imucal_correct(&out[i].gx, &out[i].ax);
+    }
+
+    // INT1 stays high while the FIFO is over the watermark, there won't be an edge for what is left
+    if (words - n * IMU_FIFO_WORDS >= imu_fifo_watermark * IMU_FIFO_WORDS){
+        imu_fifo_flag = 1;
+    }
+    return n;
+}
+
+unsigned int imu_fifo_overruns(){
+    return imu_fifo_overrun_count;
 }
 
 void bar_x(signed short accel, int color){
@@ -9,9 +9,104 @@
 #define IMU_CTRL1_XL 0x10
 #define IMU_CTRL2_G 0x11
 #define IMU_CTRL3_C 0x12
+#define IMU_FIFO_CTRL1 0x06
+#define IMU_FIFO_CTRL2 0x07
+#define IMU_FIFO_CTRL3 0x08
+#define IMU_FIFO_CTRL4 0x09
+#define IMU_FIFO_CTRL5 0x0A
+#define IMU_INT1_CTRL 0x0D
+#define IMU_STATUS_REG 0x1E
 #define IMU_OUT_TEMP_L 0x20
+#define IMU_FIFO_STATUS1 0x3A
+#define IMU_FIFO_STATUS2 0x3B
+#define IMU_FIFO_STATUS3 0x3C
+#define IMU_FIFO_STATUS4 0x3D
+#define IMU_FIFO_DATA_OUT_L 0x3E
+
+// Full scales, set by imu_setup(). The scales below follow from them at compile time, so
+// converting a sample is a multiply and a shift
+#define IMU_XL_FS_G 2 // accelerometer, 2 4 8 or 16 g
+#define IMU_G_FS_DPS 1000 // gyro, 245 500 1000 or 2000 dps
+
+#if IMU_XL_FS_G == 2
+#define IMU_XL_FS_BITS 0b00
+#elif IMU_XL_FS_G == 4
+#define IMU_XL_FS_BITS 0b10
+#elif IMU_XL_FS_G == 8
+#define IMU_XL_FS_BITS 0b11
+#elif IMU_XL_FS_G == 16
+#define IMU_XL_FS_BITS 0b01
+#else
+#error "IMU_XL_FS_G has to be 2, 4, 8 or 16"
+#endif
+
+#if IMU_G_FS_DPS == 245
+#define IMU_G_FS_BITS 0b00
+#elif IMU_G_FS_DPS == 500
+#define IMU_G_FS_BITS 0b01
+#elif IMU_G_FS_DPS == 1000
+#define IMU_G_FS_BITS 0b10
+#elif IMU_G_FS_DPS == 2000
+#define IMU_G_FS_BITS 0b11
+#else
+#error "IMU_G_FS_DPS has to be 245, 500, 1000 or 2000"
+#endif
+
+#define IMU_XL_MG_Q16 (IMU_XL_FS_G * 1999) // 0.061 mg/LSB at 2g, doubling with the scale, Q16
+#define IMU_XL_1G (65536 * 1000 / IMU_XL_MG_Q16) // LSB in 1g
+#define IMU_G_MDPS_Q8 (IMU_G_FS_DPS == 245 ? 2240 : IMU_G_FS_DPS * 2240 / 250) // 8.75 mdps/LSB at 245dps, Q8
+#define IMU_ACCEL_MG(x) (((int) (x) * IMU_XL_MG_Q16) >> 16)
+#define IMU_GYRO_MDPS(x) (((int) (x) * IMU_G_MDPS_Q8) >> 8)
+#define IMU_TEMP_CENTI(x) (2500 + (((int) (x) * 25) >> 2)) // 16 LSB/C, 0 is 25C
+
+// One sample as the registers from IMU_OUT_TEMP_L hold it, little endian shorts with no
+// padding, so imu_read() reads straight into it
+typedef struct {
+    signed short temp;
+    signed short gx, gy, gz;
+    signed short ax, ay, az;
+} imuRaw;
+
+// Data-ready sampling
+// The IMU raises its INT1 pin when a new sample is ready (accel data-ready, the gyro runs at
+// the same ODR) and keeps it high until the sample is read. INT1 goes to RPB14, whose
+// external interrupt reads the sample into a ring, so every sample is read once, as soon
+// as the I2C bus is free. Nothing may reset the core timer while sampling, it is the
+// timestamp.
+#define IMU_RING_SIZE 32 // samples, power of 2
+
+typedef struct {
+    unsigned int time; // core timer at the data-ready edge
+    imuRaw raw;
+} imuSample;
+
+// FIFO mode
+// The IMU puts every gyro and accel sample in its 4096 word FIFO (continuous mode, oldest
+// samples are overwritten when it is full) and raises INT1 once watermark samples are in
+// it. The interrupt only sets a flag, imu_fifo_read() then reads the whole lot in one burst,
+// so a sample costs 12 bytes on the bus instead of a 17 byte transaction of its own. The
+// FIFO keeps about 400mS of samples at 1.66kHz, so the read can wait for the display.
+// The FIFO words come in the order gyro x y z, accel x y z, little endian like the PIC32,
+// so the burst goes straight into an array of imuFifoSample.
+#define IMU_FIFO_WORDS 6 // FIFO words per sample
+#define IMU_FIFO_MAX_WATERMARK 600 // samples, 4096 words leave some room past the watermark
+
+typedef struct {
+    signed short gx, gy, gz; // FIFO data set 1
+    signed short ax, ay, az; // FIFO data set 2
+} imuFifoSample;
 
 void imu_setup();
-void imu_read(unsigned char, signed short *, int);
+void imu_read(imuRaw * raw); // one sample, main code
+void imu_drdy_start(void);
+void imu_drdy_stop(void);
+int imu_available(void); // samples waiting in the ring
+int imu_get(imuSample * sample); // oldest sample, returns 0 right away if there is none
+unsigned int imu_overflows(void); // samples dropped because the ring was full
+void imu_fifo_start(int watermark); // samples per burst, also stops data-ready sampling
+void imu_fifo_stop(void);
+int imu_fifo_ready(void); // the watermark was reached since the last imu_fifo_read()
+int imu_fifo_read(imuFifoSample * out, int max); // up to max of the oldest samples, returns how many
+unsigned int imu_fifo_overruns(void); // reads that found the FIFO had overwritten samples
 
 #endif
@@ -0,0 +1,331 @@
+// ahrs.c on the PC.
+// ahrs_atan2() against atan2() for every small integer pair and for random pairs of every
+// size up to the whole int range, within 2 centidegrees: small inputs have to get the same
+// 16 CORDIC steps of accuracy as big ones.
+// Then both filters start level with the board held nearly upside down and still, and have to
+// end up at the measured roll. On the way there the estimated and the measured gravity point
+// almost opposite ways, the largest error Madgwick's step has to handle. Exactly upside down
+// v - a is 2 in z, and one gyro LSB of nudge gets Madgwick off the saddle to turn over. It is
+// built with -fsanitize=signed-integer-overflow, so an int that overflows on the way fails it.
+// Last, both filters are run on synthetic recordings of a moving board next to the same
+// filter in double precision (the equations of ahrs.c, exact normalization, the gyro scale of
+// imu.h), fed the same quantized and noisy samples. The quaternion of the fixed point filter
+// has to stay within REF_DEG of the double one, and roll, pitch and yaw within REF_DEG too
+// (roll and yaw only while pitch is under 80 degrees, they are undefined at 90). The double
+// filter has to follow the true orientation within TRUTH_DEG, so the recordings really move it.
+#include "check.h"
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ahrs.h"
+
+#define RATE 1660 // samples/s, like imu.c
+#define SECONDS 120
+
+static double worst_atan = 0;
+
+static void check_atan2(int y, int x) {
+    double want, err;
+    int got = ahrs_atan2(y, x);
+    if (x == 0 && y == 0) {
+        CHECK(got == 0, "atan2(0, 0) is %d", got);
+        return;
+    }
+    want = atan2(y, x) * 18000 / M_PI;
+    err = fabs(got - want);
+    if (err > 18000) {
+        err = 36000 - err; // -18000 and 18000 are the same
+    }
+    if (err > worst_atan) {
+        worst_atan = err;
+    }
+    CHECK(err <= 2, "atan2(%d, %d) is %d, not %.1f", y, x, got, want);
+}
+
+// gaussian from two uniforms (Box-Muller)
+static double gauss() {
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double v = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+}
+
+// random int of a random number of bits, either sign
+static int random_int() {
+    int bits = rand() % 32;
+    long long v = ((long long) rand() << 16 ^ rand()) & ((1LL << bits) - 1);
+    return rand() & 1 ? -v : v;
+}
+
+// a still board, gravity at roll degrees about x, from level
+static double settle(int algorithm, double roll, int nudge) {
+    int i, r, p, y;
+    int ay = 16384 * sin(roll * M_PI / 180);
+    int az = 16384 * cos(roll * M_PI / 180);
+    ahrsQuat q;
+    double n;
+
+    ahrs_setup(algorithm, RATE);
+    for (i = 0; i < SECONDS * RATE; i++) {
+        ahrs_update(i == 0 ? nudge : 0, 0, 0, 0, ay, az);
+    }
+    ahrs_quaternion(&q);
+    n = sqrt((double) q.q0 * q.q0 + (double) q.q1 * q.q1 + (double) q.q2 * q.q2 + (double) q.q3 * q.q3) / AHRS_ONE;
+    CHECK(fabs(n - 1) < 0.001, "%s: |q| is %.4f", algorithm == AHRS_MADGWICK ? "Madgwick" : "complementary", n);
+    ahrs_euler(&r, &p, &y);
+    return r / 100.0;
+}
+
+// Recordings and the double precision reference
+
+#define REF_DEG 0.1 // fixed point against double
+#define TRUTH_DEG 1.0 // double against the true orientation
+#define REC_SECONDS 30
+#define SUBSTEPS 8 // of the true motion per sample
+#define GYRO_RAD (IMU_G_MDPS_Q8 / 256.0 / 1000 * M_PI / 180) // rad/s per gyro LSB
+#define DEG (M_PI / 180)
+
+#define RECORDINGS 4
+static const char * rec_names[RECORDINGS] = {
+    "roll and yaw 100dps", "tumble on 3 axes", "pitch swings to 70deg", "shaking, 0.3g and gyro bias"
+};
+
+// true body rates in rad/s at time t
+static void rec_rates(int rec, double t, double * w) {
+    switch (rec) {
+        case 0: // roll back and forth 100dps, yaw 100dps all the time, with stops
+            w[0] = (fmod(t, 8) < 3 ? 100 : fmod(t, 8) < 4 ? 0 : fmod(t, 8) < 7 ? -100 : 0) * DEG;
+            w[1] = 0;
+            w[2] = 100 * DEG;
+            break;
+        case 1:
+            w[0] = 150 * DEG * sin(2 * M_PI * 0.3 * t);
+            w[1] = 60 * DEG * sin(2 * M_PI * 0.23 * t + 1);
+            w[2] = 120 * DEG * sin(2 * M_PI * 0.17 * t + 2);
+            break;
+        case 2: // pitch 70 degrees each way at 0.25Hz, some roll
+            w[0] = 30 * DEG * sin(2 * M_PI * 0.4 * t);
+            w[1] = 70 * DEG * 2 * M_PI * 0.25 * cos(2 * M_PI * 0.25 * t);
+            w[2] = 0;
+            break;
+        default: // small fast turns
+            w[0] = 40 * DEG * sin(2 * M_PI * 3 * t);
+            w[1] = 40 * DEG * sin(2 * M_PI * 2.3 * t);
+            w[2] = 20 * DEG * sin(2 * M_PI * 1.1 * t);
+            break;
+    }
+}
+
+// q * (0, w) / 2 over dt, exact for constant w
+static void quat_turn(double * q, const double * w, double dt) {
+    double n = sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+    double c = cos(n * dt / 2), k = n > 0 ? sin(n * dt / 2) / n : 0;
+    double r[4] = {c, w[0] * k, w[1] * k, w[2] * k};
+    double p[4];
+    p[0] = q[0] * r[0] - q[1] * r[1] - q[2] * r[2] - q[3] * r[3];
+    p[1] = q[0] * r[1] + q[1] * r[0] + q[2] * r[3] - q[3] * r[2];
+    p[2] = q[0] * r[2] - q[1] * r[3] + q[2] * r[0] + q[3] * r[1];
+    p[3] = q[0] * r[3] + q[1] * r[2] - q[2] * r[1] + q[3] * r[0];
+    memcpy(q, p, sizeof(p));
+}
+
+// gravity in the sensor frame, like v in ahrs_update()
+static void quat_gravity(const double * q, double * v) {
+    v[0] = 2 * (q[1] * q[3] - q[0] * q[2]);
+    v[1] = 2 * (q[0] * q[1] + q[2] * q[3]);
+    v[2] = q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3];
+}
+
+// degrees, like ahrs_euler()
+static void quat_euler(const double * q, double * e) {
+    double v[3];
+    quat_gravity(q, v);
+    e[0] = atan2(v[1], v[2]) / DEG;
+    e[1] = atan2(-v[0], sqrt(v[1] * v[1] + v[2] * v[2])) / DEG;
+    e[2] = atan2(2 * (q[0] * q[3] + q[1] * q[2]), 1 - 2 * (q[2] * q[2] + q[3] * q[3])) / DEG;
+}
+
+// angle between two orientations, degrees
+static double quat_angle(const double * a, const double * b) {
+    double d = fabs(a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3]);
+    return 2 * acos(d > 1 ? 1 : d) / DEG;
+}
+
+static double angle_diff(double a, double b) {
+    double d = fmod(a - b + 540, 360) - 180;
+    return fabs(d);
+}
+
+static void quat_normalize(double * q, int n) {
+    double l = 0;
+    int i;
+    for (i = 0; i < n; i++) {
+        l += q[i] * q[i];
+    }
+    l = sqrt(l);
+    for (i = 0; i < n; i++) {
+        q[i] /= l;
+    }
+}
+
+// ahrs_update() in double
+static void ref_update(int algorithm, double * q, int gx, int gy, int gz, int ax, int ay, int az) {
+    double w[3] = {gx * GYRO_RAD, gy * GYRO_RAD, gz * GYRO_RAD};
+    double a[3] = {ax, ay, az};
+    double v[3], f[3], s[4] = {0, 0, 0, 0};
+    double dt = 1.0 / RATE;
+    double d[4];
+    int i;
+
+    if (ax != 0 || ay != 0 || az != 0) {
+        quat_normalize(a, 3);
+        quat_gravity(q, v);
+        if (algorithm == AHRS_MADGWICK) {
+            for (i = 0; i < 3; i++) {
+                f[i] = v[i] - a[i];
+            }
+            s[0] = -q[2] * f[0] + q[1] * f[1];
+            s[1] = q[3] * f[0] + q[0] * f[1] - 2 * q[1] * f[2];
+            s[2] = -q[0] * f[0] + q[3] * f[1] - 2 * q[2] * f[2];
+            s[3] = q[1] * f[0] + q[2] * f[1];
+            if (s[0] != 0 || s[1] != 0 || s[2] != 0 || s[3] != 0) {
+                quat_normalize(s, 4);
+                for (i = 0; i < 4; i++) {
+                    s[i] *= AHRS_BETA / 65536.0 * dt;
+                }
+            }
+        } else {
+            w[0] += AHRS_KP / 65536.0 * (a[1] * v[2] - a[2] * v[1]);
+            w[1] += AHRS_KP / 65536.0 * (a[2] * v[0] - a[0] * v[2]);
+            w[2] += AHRS_KP / 65536.0 * (a[0] * v[1] - a[1] * v[0]);
+        }
+    }
+    d[0] = (-q[1] * w[0] - q[2] * w[1] - q[3] * w[2]) * dt / 2;
+    d[1] = (q[0] * w[0] + q[2] * w[2] - q[3] * w[1]) * dt / 2;
+    d[2] = (q[0] * w[1] - q[1] * w[2] + q[3] * w[0]) * dt / 2;
+    d[3] = (q[0] * w[2] + q[1] * w[1] - q[2] * w[0]) * dt / 2;
+    for (i = 0; i < 4; i++) {
+        q[i] += d[i] - s[i];
+    }
+    quat_normalize(q, 4);
+}
+
+// run one recording through the fixed and the double filter, print the worst errors
+static void run_recording(int rec, int algorithm) {
+    double truth[4] = {1, 0, 0, 0}, ref[4] = {1, 0, 0, 0};
+    double fix[4], w[3], v[3], e_ref[3], e_fix[3];
+    double worst_q = 0, worst_e[3] = {0, 0, 0}, worst_truth = 0, t = 0, err;
+    double bias[3] = {0, 0, 0}, lin = 0;
+    const char * name = algorithm == AHRS_MADGWICK ? "Madgwick" : "complementary";
+    int gyro[3], acc[3];
+    int i, j, k, r, p, y;
+    ahrsQuat q;
+
+    if (rec == 3) {
+        bias[0] = 0.5 * DEG; // both filters see it the same, yaw has nothing to correct it
+        bias[1] = -0.3 * DEG;
+        lin = 0.3;
+    }
+    ahrs_setup(algorithm, RATE);
+    for (i = 0; i < REC_SECONDS * RATE; i++) {
+        // the true motion over the sample, the gyro averages it
+        for (k = 0; k < 3; k++) {
+            gyro[k] = 0;
+        }
+        for (j = 0; j < SUBSTEPS; j++) {
+            rec_rates(rec, t, w);
+            quat_turn(truth, w, 1.0 / (RATE * SUBSTEPS));
+            t += 1.0 / (RATE * SUBSTEPS);
+        }
+        rec_rates(rec, t - 0.5 / RATE, w);
+        quat_gravity(truth, v);
+        for (k = 0; k < 3; k++) {
+            gyro[k] = (int) floor((w[k] + bias[k]) / GYRO_RAD + 3 * gauss() + 0.5);
+            acc[k] = (int) floor((v[k] + lin * gauss() + 0.005 * gauss()) * IMU_XL_1G + 0.5);
+        }
+
+        ahrs_update(gyro[0], gyro[1], gyro[2], acc[0], acc[1], acc[2]);
+        ref_update(algorithm, ref, gyro[0], gyro[1], gyro[2], acc[0], acc[1], acc[2]);
+
+        ahrs_quaternion(&q);
+        fix[0] = (double) q.q0 / AHRS_ONE;
+        fix[1] = (double) q.q1 / AHRS_ONE;
+        fix[2] = (double) q.q2 / AHRS_ONE;
+        fix[3] = (double) q.q3 / AHRS_ONE;
+        err = quat_angle(fix, ref);
+        worst_q = fmax(worst_q, err);
+        CHECK(err <= REF_DEG, "%s, %s: %.3f degrees from double at %.3fs", rec_names[rec], name, err, t);
+        if (rec != 3) { // the bias adds up in yaw, that is no fault of the filter
+            worst_truth = fmax(worst_truth, quat_angle(ref, truth));
+        }
+
+        ahrs_euler(&r, &p, &y);
+        e_fix[0] = r / 100.0;
+        e_fix[1] = p / 100.0;
+        e_fix[2] = y / 100.0;
+        quat_euler(ref, e_ref);
+        for (k = 0; k < 3; k++) {
+            if (k != 1 && fabs(e_ref[1]) > 80) {
+                continue;
+            }
+            err = angle_diff(e_fix[k], e_ref[k]);
+            worst_e[k] = fmax(worst_e[k], err);
+            CHECK(err <= REF_DEG, "%s, %s: Euler angle %d is %.2f, double %.2f at %.3fs",
+                    rec_names[rec], name, k, e_fix[k], e_ref[k], t);
+        }
+    }
+    printf("%-28s %-13s %6.3f  %6.3f %6.3f %6.3f", rec_names[rec], name, worst_q,
+            worst_e[0], worst_e[1], worst_e[2]);
+    if (rec != 3) {
+        printf("  %6.2f\n", worst_truth);
+        CHECK(worst_truth <= TRUTH_DEG, "%s, %s: double is %.2f degrees from the truth", rec_names[rec], name, worst_truth);
+    } else {
+        printf("       -\n");
+    }
+}
+
+int main() {
+    int x, y, i;
+    double roll, got;
+    static const double rolls[] = {30, 90, 170, 179, -179};
+
+    for (y = -20; y <= 20; y++) {
+        for (x = -20; x <= 20; x++) {
+            check_atan2(y, x);
+        }
+    }
+    CHECK(ahrs_atan2(1, 1) == 4500, "atan2(1, 1) is %d", ahrs_atan2(1, 1));
+    check_atan2(INT_MAX, INT_MAX);
+    check_atan2(INT_MIN, INT_MIN);
+    check_atan2(INT_MIN, INT_MAX);
+    check_atan2(1, INT_MIN);
+    check_atan2(-1, INT_MIN);
+    check_atan2(INT_MAX, 1);
+    srand(5);
+    for (i = 0; i < 1000000; i++) {
+        check_atan2(random_int(), random_int());
+    }
+    printf("ahrs_atan2: worst %.2f centidegrees\n", worst_atan);
+
+    for (i = 0; i < (int) (sizeof(rolls) / sizeof(rolls[0])); i++) {
+        roll = rolls[i];
+        got = settle(AHRS_COMPLEMENTARY, roll, 0);
+        printf("roll %6.1f: complementary %7.2f", roll, got);
+        CHECK(fabs(got - roll) < 0.5, "complementary settled at %.2f, not %.1f", got, roll);
+        got = settle(AHRS_MADGWICK, roll, 0);
+        printf(", Madgwick %7.2f\n", got);
+        CHECK(fabs(got - roll) < 0.5, "Madgwick settled at %.2f, not %.1f", got, roll);
+    }
+    got = settle(AHRS_MADGWICK, 180, 1);
+    printf("roll  180.0 from a 1 LSB nudge: Madgwick %7.2f\n", got);
+    CHECK(fabs(fabs(got) - 180) < 0.5, "Madgwick settled at %.2f upside down", got);
+
+    printf("%-28s %-13s  worst degrees from double: q  roll  pitch  yaw, double from the truth\n",
+            "recording", "filter");
+    srand(17);
+    for (i = 0; i < RECORDINGS; i++) {
+        run_recording(i, AHRS_COMPLEMENTARY);
+        run_recording(i, AHRS_MADGWICK);
+    }
+    return check_done("test_ahrs");
+}
@@ -0,0 +1,7 @@
+#ifndef XC_H__
+#define XC_H__
+
+// Host stand-in for the XC32 <xc.h>. ahrs.c is plain integer math and touches no registers,
+// the IMU headers only need it to be there.
+
+#endif
@@ -1,10 +1,20 @@
 #include<xc.h>           // processor SFR definitions
 #include<sys/attribs.h>  // __ISR macro
+#include<sys/kmem.h>     // KVA_TO_PA for the DMA addresses
 #include "adc.h"
 #include "ws2812b.h"
 #include "ssd1306.h"
+#include "touch.h"
+#include "dsp.h"
+#include "fft.h"
 
 #define SAMPLE_TIME 10 // in core timer ticks, use a minimum of 250 ns
+#define HSB_BENCHMARK 0 // 1 to show the cycles of the float and the fixed HSBtoRGB at startup
+#define DSP_BENCHMARK 0 // 1 to show the cycles per sample of the dsp.c filters at startup
+#define FFT_BENCHMARK 0 // 1 to show the cycles per FFT of 64 to 512 points at startup
+#define SPECTRUM_MODE 0 // 1 to show the spectrum of SPECTRUM_PIN on the OLED instead of the touch slider
+#define SPECTRUM_PIN 5 // AN5 is B3
+#define SPECTRUM_RATE 8000 // samples per second, the bars go up to half of it
 
 
 // DEVCFG0
@@ -56,83 +66,199 @@ int main() {
     // disable JTAG to get pins back
     DDPCONbits.JTAGEN = 0;
     
+    __builtin_enable_interrupts();
+
     i2c_master_setup();        
     ssd1306_setup();    
     ws2812b_setup();
+    ws2812b_setBrightness(26); // global brightness 0.1, applied after the gamma
     adc_setup();
     ctmu_setup();
+
+    if (SPECTRUM_MODE) {
+        // FFT of every ADC_STREAM_BLOCK samples as bars, the blocks that come in while
+        // the OLED is being sent are skipped
+        static short re[ADC_STREAM_BLOCK];
+        static short im[ADC_STREAM_BLOCK];
+        static unsigned short mag[ADC_STREAM_BLOCK / 2];
+        unsigned short * block;
+        int k;
+        adc_stream_start(SPECTRUM_PIN, SPECTRUM_RATE);
+        while (1) {
+            block = adc_stream_get();
+            if (block == 0) {
+                continue;
+            }
+            dsp_fromAdc(block, re, ADC_STREAM_BLOCK);
+            for (k = 0; k < ADC_STREAM_BLOCK; k++) {
+                im[k] = 0;
+            }
+            fft_window(re, 7); // 2^7 = ADC_STREAM_BLOCK
+            fft(re, im, 7);
+            fft_magnitude(re, im, mag, ADC_STREAM_BLOCK / 2);
+            fft_drawBars(mag, ADC_STREAM_BLOCK / 2);
+            ssd1306_update();
+        }
+    }
+    // measure both triangles in the background, charging 150 core ticks like before
+    int touch_pins[2] = {0, 1};
+    ctmu_start(touch_pins, 2, 150);
        
     unsigned char ssd1306_write = 0b01111000; // 0111100 i2c address unique address of ssd1306
     unsigned char ssd1306_read = 0b01111001; //   
     unsigned char ssd1306_buffer[512]; // 128x32/8. Every bit is a pixel      
     char message[200];
     // Variables for capacitance
-    int Baseline_AN0 = 0;
-    int Baseline_AN1 = 0;
-    int touched_AN0;
-    int touched_AN1;
+    int counts[2];
     int i;
-    int int_times=10;
-    //Variables for capacitive touch slider
-    int Delta_Left;
-    int Delta_Right;
-    float Left_Position;
-    float Right_Position;
-    float Position;
-
-    //Calculate baseline capacitance    
-    for (i=0; i < int_times; i++){
-        Baseline_AN0 += ctmu_read(0, 150);
-        Baseline_AN1 += ctmu_read(1, 150);
+    //Variables for capacitive touch slider, 0 on AN0 to TOUCH_POS_SCALE on AN1
+    int Position;
+
+    //Calculate baseline capacitance once the filtered counts have settled, touch.c tracks it from then on
+    touch_setup(2, 0);
+    while (ctmu_scans() < 64) {
     }
+    counts[0] = ctmu_count(0);
+    counts[1] = ctmu_count(1);
+    touch_calibrate(counts);
     // Variables for LEDs
     int numLEDs = 4;
-    float Brightness;
+    int Brightness;
     wsColor c[numLEDs];
+
+    if (HSB_BENCHMARK) {
+        // time 360 conversions of each, the core timer counts every 2 cycles
+        unsigned int start;
+        unsigned int float_cycles;
+        unsigned int fixed_cycles;
+        start = _CP0_GET_COUNT();
+        for (i = 0; i < 360; i++) {
+            c[0] = HSBtoRGB(i, 0.5, 0.1);
+        }
+        float_cycles = (_CP0_GET_COUNT() - start) * 2 / 360;
+        start = _CP0_GET_COUNT();
+        for (i = 0; i < 360; i++) {
+            c[0] = HSBtoRGB_fixed(i * 4, 128, 26);
+        }
+        fixed_cycles = (_CP0_GET_COUNT() - start) * 2 / 360;
+        sprintf(message, "float HSB %d cyc", float_cycles);
+        drawMessage(0, 0, message);
+        sprintf(message, "fixed HSB %d cyc", fixed_cycles);
+        drawMessage(0, 8, message);
+        ssd1306_update();
+        _CP0_SET_COUNT(0);
+        while (_CP0_GET_COUNT() < 24000000 * 3) {} // show it for 3s
+        ssd1306_clear();
+    }
+
+    if (FFT_BENCHMARK) {
+        // one transform of each size, the core timer counts every 2 cycles
+        static short re[FFT_MAX_N];
+        static short im[FFT_MAX_N];
+        unsigned int start;
+        int log2n;
+        for (log2n = 6; log2n <= FFT_MAX_LOG2; log2n++) {
+            for (i = 0; i < (1 << log2n); i++) {
+                re[i] = (i * 997) & 0x3FFF;
+                im[i] = 0;
+            }
+            start = _CP0_GET_COUNT();
+            fft(re, im, log2n);
+            sprintf(message, "fft%d %d cyc", 1 << log2n, (_CP0_GET_COUNT() - start) * 2);
+            drawMessage(0, (log2n - 6) * 8, message);
+        }
+        ssd1306_update();
+        start = _CP0_GET_COUNT();
+        while (_CP0_GET_COUNT() - start < 24000000 * 3) {} // show it for 3s
+        ssd1306_clear();
+    }
+
+    if (DSP_BENCHMARK) {
+        // filter a 128 sample block with each, the core timer counts every 2 cycles
+        static short fir_coeffs[32];
+        static short fir_state[64];
+        static short avg_ring[16];
+        static short dsp_in[128];
+        static short dsp_out[128];
+        static const dspBiquadCoeffs lowpass[2] = { // Butterworth, fc = 0.05 fs
+            {Q14(0.0201), Q14(0.0402), Q14(0.0201), Q14(-1.5610), Q14(0.6414)},
+            {Q14(0.0201), Q14(0.0402), Q14(0.0201), Q14(-1.5610), Q14(0.6414)}
+        };
+        short biquad_state[8];
+        dspFir fir;
+        dspBiquad biquad;
+        dspAverage avg;
+        dspMedian median;
+        unsigned int start;
+        for (i = 0; i < 32; i++) {
+            fir_coeffs[i] = Q15(1.0 / 32);
+        }
+        for (i = 0; i < 128; i++) {
+            dsp_in[i] = (i * 997) & 0x3FFF;
+        }
+        dsp_fir_init(&fir, fir_coeffs, fir_state, 32);
+        dsp_biquad_init(&biquad, lowpass, biquad_state, 2);
+        dsp_average_init(&avg, avg_ring, 4);
+        dsp_median_init(&median, 7);
+
+        start = _CP0_GET_COUNT();
+        dsp_fir_block(&fir, dsp_in, dsp_out, 128);
+        sprintf(message, "fir32 %d cyc", (_CP0_GET_COUNT() - start) * 2 / 128);
+        drawMessage(0, 0, message);
+        start = _CP0_GET_COUNT();
+        dsp_biquad_block(&biquad, dsp_in, dsp_out, 128);
+        sprintf(message, "biquad2 %d cyc", (_CP0_GET_COUNT() - start) * 2 / 128);
+        drawMessage(0, 8, message);
+        start = _CP0_GET_COUNT();
+        dsp_average_block(&avg, dsp_in, dsp_out, 128);
+        sprintf(message, "avg16 %d cyc", (_CP0_GET_COUNT() - start) * 2 / 128);
+        drawMessage(0, 16, message);
+        start = _CP0_GET_COUNT();
+        dsp_median_block(&median, dsp_in, dsp_out, 128);
+        sprintf(message, "median7 %d cyc", (_CP0_GET_COUNT() - start) * 2 / 128);
+        drawMessage(0, 24, message);
+        ssd1306_update();
+        start = _CP0_GET_COUNT();
+        while (_CP0_GET_COUNT() - start < 24000000 * 3) {} // show it for 3s
+        ssd1306_clear();
+    }
         
     while (1) {
-        touched_AN0 = 0;
-        touched_AN1 = 0;
-        for (i=0; i < int_times; i++){
-            touched_AN0 += ctmu_read(0, 150);
-            touched_AN1 += ctmu_read(1, 150);
-        }
-        Delta_Left = Baseline_AN0 - touched_AN0;
-        Delta_Right = Baseline_AN1 - touched_AN1;
-        Left_Position = Delta_Left*100./(Delta_Left + Delta_Right);
-        Right_Position = ((1 - Delta_Right)*100.)/(Delta_Left + Delta_Right);
-        Position = (Left_Position + Right_Position)/2;
+        counts[0] = ctmu_count(0);
+        counts[1] = ctmu_count(1);
+        touch_update(counts);
+        Position = touch_position();
         //Control ws2812b according to touched spot
         //Decide whether the triangles are touched, respectively.
-        if(touched_AN0 < Baseline_AN0 - 50){
-            c[0] = HSBtoRGB(120, 0.5, 0.1);
+        if(touch_isTouched(0)){
+            c[0] = HSBtoRGB_fixed(512, 128, 255);
         }else{
-            c[0] = HSBtoRGB(120, 0.5, 0);
+            c[0] = HSBtoRGB_fixed(512, 128, 0);
         }
-        if(touched_AN1 < Baseline_AN1 - 50){
-            c[1] = HSBtoRGB(120, 0.5, 0.1);
+        if(touch_isTouched(1)){
+            c[1] = HSBtoRGB_fixed(512, 128, 255);
         }else{
-            c[1] = HSBtoRGB(120, 0.5, 0);
+            c[1] = HSBtoRGB_fixed(512, 128, 0);
         }        
         // light up a WS2812B proportionally according to the position touched
-        if((touched_AN0 + touched_AN1) < (Baseline_AN0 + Baseline_AN1) -200){
+        if(Position >= 0){
             // (hue, sat, brightness) correspond to(Color in 360 degree, Full color or gray scale, brightness)
-        Brightness = 0.5
-                *(Position + 50)/100;
-            c[2] = HSBtoRGB(240, 0.5, Brightness);
-            c[3] = HSBtoRGB(240, 0.5, 0);
+            // hue 1024 of 1536 is 240 degrees, brightness 0-255 goes up towards AN0
+            Brightness = (TOUCH_POS_SCALE - Position)*255/TOUCH_POS_SCALE;
+            c[2] = HSBtoRGB_fixed(1024, 128, Brightness);
+            c[3] = HSBtoRGB_fixed(1024, 128, 0);
         }else{
-            c[2] = HSBtoRGB(240, 0.5, 0);
-            c[3] = HSBtoRGB(240, 0.5, 0);          
+            c[2] = HSBtoRGB_fixed(1024, 128, 0);
+            c[3] = HSBtoRGB_fixed(1024, 128, 0);          
         }
-        //light up the LED
-        ws2812b_setColor(&c, numLEDs);
+        //light up the LED through the gamma, global brightness and dithering
+        ws2812b_show(c, numLEDs);
                 
-        sprintf(message, "AN0_C = %5d", touched_AN0);        
+        sprintf(message, "AN0_C = %5d", counts[0]);        
         drawMessage(10, 8, message);
-        sprintf(message, "AN1_C = %5d", touched_AN1);
+        sprintf(message, "AN1_C = %5d", counts[1]);
         drawMessage(10, 16, message);
-        sprintf(message, "Pos = %f", Position);
+        sprintf(message, "Pos = %4d", Position);
         drawMessage(10, 24, message);
         ssd1306_update();                
     }
@@ -163,6 +289,329 @@ void adc_setup() {
     AD1CON1bits.ADON = 1; // turn on A/D converter
 }
 
+// Oversampling
+// The ADC takes bursts of 16 samples of one pin by itself (ASAM + auto convert, SMPI = 15)
+// into ADC1BUF0-F, CLRASAM stops it after every burst so the buffer can be summed before it
+// is written again. 4^n samples summed and shifted right n give 10+n bits, as long as there
+// is at least 1 LSB of noise on the input to spread the samples out. test/test_oversample.c
+// runs it on the simulated ADC with and without noise.
+// The ADC settings are put back afterwards, so it works between adc_sample_convert() calls,
+// but not while the scan or the CTMU engine is running.
+unsigned int adc_oversample(int pin, int n) {
+    unsigned int con1 = AD1CON1, con2 = AD1CON2, con3 = AD1CON3, chs = AD1CHS;
+    unsigned int ie = IEC0bits.AD1IE;
+    int samples, burst, i;
+    unsigned int sum = 0;
+    volatile unsigned int * buf = &ADC1BUF0;
+
+    if (n < 1) {
+        n = 1;
+    }
+    if (n > 4) {
+        n = 4;
+    }
+    samples = 1 << (2 * n);
+    burst = samples < 16 ? samples : 16;
+
+    IEC0bits.AD1IE = 0; // the flag is polled
+    AD1CON1bits.ON = 0;
+    AD1CHSbits.CH0SA = pin;
+    AD1CON1bits.SSRC = 0b111; // convert as soon as the sampling time is over
+    AD1CON1bits.CLRASAM = 1; // stop after the burst, so ADC1BUF0-F stays put until it is read
+    AD1CON1bits.ASAM = 0;
+    AD1CON2 = 0; // no scan, one 16 word buffer
+    AD1CON2bits.SMPI = burst - 1; // flag after every burst
+    AD1CON3bits.ADRC = 0; // Tad from the peripheral clock
+    AD1CON3bits.SAMC = 15; // (15 + 12) Tad = 2.25uS per sample
+    AD1CON3bits.ADCS = 1; // Tad = 83ns like adc_setup()
+    AD1CON1bits.ON = 1;
+
+    while (samples > 0) {
+        IFS0bits.AD1IF = 0;
+        AD1CON1bits.ASAM = 1; // go, cleared by the ADC after the burst
+        while (!IFS0bits.AD1IF) {
+            ; // burst-1 more samples are converted with no help from the CPU
+        }
+        for (i = 0; i < burst; i++) {
+            sum += buf[i * 4]; // ADC1BUFx are 16 bytes apart
+        }
+        samples -= burst;
+    }
+    IFS0bits.AD1IF = 0;
+
+    // put the ADC back the way it was
+    AD1CON1bits.ON = 0;
+    AD1CON2 = con2;
+    AD1CON3 = con3;
+    AD1CHS = chs;
+    AD1CON1 = con1;
+    IEC0bits.AD1IE = ie;
+
+    return sum >> n; // decimate to 10+n bits
+}
+
+// Timer triggered stream
+// Timer3 ends the sampling and starts a conversion of one pin on every period match
+// (SSRC = 010), so the samples are exactly 1/rate apart no matter what the CPU is doing.
+// DMA channel 2 moves every result from ADC1BUF0 into a two block ping-pong buffer and
+// interrupts when the first block (half) and the second block (full) are done.
+// adc_stream_get() hands out the finished blocks in order. A block has to be used before
+// the DMA comes back around to it, ADC_STREAM_BLOCK samples later.
+// Uses the ADC alone, not with the scan, the CTMU engine or adc_oversample().
+
+unsigned short adc_stream_buf[2 * ADC_STREAM_BLOCK];
+volatile int adc_stream_ready = 0; // bit b set when block b is done and not taken yet
+volatile unsigned int adc_stream_overruns = 0; // blocks done again before they were taken
+int adc_stream_next = 0; // block adc_stream_get() hands out next
+
+static void adc_stream_done(int b) {
+    if (adc_stream_ready & (1 << b)) {
+        adc_stream_overruns++;
+    }
+    adc_stream_ready |= 1 << b;
+}
+
+void __ISR(_DMA_2_VECTOR, IPL3SOFT) adc_stream_isr(void) {
+    if (DCH2INTbits.CHDHIF) {
+        DCH2INTCLR = _DCH2INT_CHDHIF_MASK;
+        adc_stream_done(0);
+    }
+    if (DCH2INTbits.CHDDIF) {
+        DCH2INTCLR = _DCH2INT_CHDDIF_MASK;
+        adc_stream_done(1);
+    }
+    IFS1bits.DMA2IF = 0;
+}
+
+// sample AN pin at rate samples per second, up to ADC_STREAM_MAX_RATE, down to about 3Hz
+void adc_stream_start(int pin, unsigned int rate) {
+    static const unsigned short prescale[8] = {1, 2, 4, 8, 16, 32, 64, 256};
+    int ps = 0;
+
+    adc_stream_stop();
+    if (rate > ADC_STREAM_MAX_RATE) {
+        rate = ADC_STREAM_MAX_RATE;
+    }
+    if (rate < 3) {
+        rate = 3;
+    }
+    // smallest prescaler the period fits with
+    while (ps < 7 && 48000000 / prescale[ps] / rate > 65536) {
+        ps++;
+    }
+
+    adc_stream_ready = 0;
+    adc_stream_overruns = 0;
+    adc_stream_next = 0;
+
+    IEC0bits.AD1IE = 0; // the ADC flag only triggers the DMA
+    AD1CON1bits.ON = 0;
+    AD1CHSbits.CH0SA = pin;
+    AD1CON1bits.SSRC = 0b010; // Timer3 period match starts the conversion
+    AD1CON1bits.CLRASAM = 0;
+    AD1CON1bits.ASAM = 1; // sample again right after every conversion, until the next match
+    AD1CON2 = 0; // no scan, every result in ADC1BUF0
+    AD1CON3bits.ADRC = 0; // Tad from the peripheral clock
+    AD1CON3bits.ADCS = 1; // Tad = 83ns like adc_setup()
+
+    DMACONbits.ON = 1; // turn on the DMA controller
+    DCH2CON = 0;
+    DCH2ECON = 0;
+    DCH2ECONbits.CHSIRQ = _ADC_IRQ; // one result per conversion
+    DCH2ECONbits.SIRQEN = 1;
+    DCH2SSA = KVA_TO_PA(&ADC1BUF0);
+    DCH2SSIZ = 2;
+    DCH2DSA = KVA_TO_PA(adc_stream_buf);
+    DCH2DSIZ = sizeof(adc_stream_buf);
+    DCH2CSIZ = 2;
+    DCH2INTCLR = 0xFF; // clear the channel event flags
+    DCH2INTbits.CHDHIE = 1; // interrupt when the first block is full
+    DCH2INTbits.CHDDIE = 1; // and when the second one is
+    DCH2CONbits.CHAEN = 1; // start over at the first block forever
+    DCH2CONbits.CHPRI = 2;
+    IPC10bits.DMA2IP = 3; // same as IPL3SOFT in the ISR
+    IPC10bits.DMA2IS = 0;
+    IFS1bits.DMA2IF = 0;
+    IEC1bits.DMA2IE = 1;
+    DCH2CONbits.CHEN = 1;
+
+    T3CON = 0;
+    T3CONbits.TCKPS = ps;
+    PR3 = 48000000 / prescale[ps] / rate - 1;
+    TMR3 = 0;
+    AD1CON1bits.ON = 1;
+    T3CONbits.ON = 1; // go
+}
+
+// stop the stream and put the ADC back in manual mode for adc_sample_convert() and ctmu_read()
+void adc_stream_stop() {
+    T3CONbits.ON = 0;
+    IEC1bits.DMA2IE = 0;
+    DCH2CONbits.CHEN = 0;
+    DCH2CONbits.CHAEN = 0;
+    IFS1bits.DMA2IF = 0;
+    AD1CON1bits.ON = 0;
+    AD1CON1bits.ASAM = 0;
+    AD1CON1bits.SSRC = 0b000; // clearing SAMP starts the conversion
+    AD1CON2 = 0;
+    IFS0bits.AD1IF = 0;
+    AD1CON1bits.ON = 1;
+    adc_stream_ready = 0;
+}
+
+// the next finished block of ADC_STREAM_BLOCK samples, or 0 if it isn't done yet
+unsigned short * adc_stream_get() {
+    int b = adc_stream_next;
+    unsigned int status;
+    if (!(adc_stream_ready & (1 << b))) {
+        return 0;
+    }
+    status = __builtin_disable_interrupts(); // the ISR sets the other bit
+    adc_stream_ready &= ~(1 << b);
+    if (status & 1) { // only turn them back on if they were on
+        __builtin_enable_interrupts();
+    }
+    adc_stream_next = !b;
+    return &adc_stream_buf[b * ADC_STREAM_BLOCK];
+}
+
+// blocks that were done again before adc_stream_get() took them
+unsigned int adc_stream_overrunCount() {
+    return adc_stream_overruns;
+}
+
+// Auto scan
+// The ADC samples and converts the channels in mask one after the other by itself
+// (ASAM, SSRC auto convert, CSCNA), and interrupts after every pass of the scan list.
+// The buffer is split in two halves (BUFM) so the ISR reads one half while the next pass
+// fills the other. Every channel has its own ring, the ISR only writes the head and the
+// main loop only writes the tail, so reading never has to turn interrupts off.
+
+volatile unsigned short adc_ring[ADC_SCAN_MAX][ADC_RING_SIZE];
+volatile unsigned int adc_ring_head[ADC_SCAN_MAX]; // written by the ISR
+volatile unsigned int adc_ring_tail[ADC_SCAN_MAX]; // written by adc_scan_read()
+volatile unsigned int adc_ring_overflows[ADC_SCAN_MAX]; // samples dropped because the ring was full
+signed char adc_scan_slot[16]; // ring of every AN pin, -1 if it isn't scanned
+int adc_scan_count = 0; // channels in the scan list
+
+void __ISR(_ADC_VECTOR, IPL5SOFT) adc_scan_isr(void) {
+    // BUFS = 1 means the ADC is filling ADC1BUF8-F, so ADC1BUF0-7 are ready, and the other way round
+    volatile unsigned int * buf = AD1CON2bits.BUFS ? &ADC1BUF0 : &ADC1BUF8;
+    int i;
+    unsigned int head;
+    for (i = 0; i < adc_scan_count; i++) {
+        head = adc_ring_head[i];
+        if (head - adc_ring_tail[i] < ADC_RING_SIZE) {
+            adc_ring[i][head & (ADC_RING_SIZE - 1)] = buf[i * 4]; // ADC1BUFx are 16 bytes apart
+            adc_ring_head[i] = head + 1;
+        } else {
+            adc_ring_overflows[i]++;
+        }
+    }
+    IFS0bits.AD1IF = 0;
+}
+
+// scan the AN pins set in mask (up to ADC_SCAN_MAX of AN0-AN15) over and over.
+// One conversion takes (31 + 12) * 2*(adcs+1) / 48MHz: adcs 1 -> 3.6uS, adcs 255 -> 460uS
+void adc_scan_start(unsigned int mask, unsigned char adcs) {
+    int i;
+    if (adcs < 1) {
+        adcs = 1; // Tad has to be at least 75ns
+    }
+    adc_scan_stop();
+
+    adc_scan_count = 0;
+    for (i = 0; i < 16; i++) {
+        adc_scan_slot[i] = -1;
+        if (((mask >> i) & 1) && adc_scan_count < ADC_SCAN_MAX) {
+            adc_scan_slot[i] = adc_scan_count;
+            adc_ring_head[adc_scan_count] = 0;
+            adc_ring_tail[adc_scan_count] = 0;
+            adc_ring_overflows[adc_scan_count] = 0;
+            adc_scan_count++;
+        } else {
+            mask &= ~(1 << i); // past ADC_SCAN_MAX
+        }
+    }
+    if (adc_scan_count == 0) {
+        return;
+    }
+
+    AD1CON1bits.ON = 0;
+    AD1CSSL = mask; // the scan list, in AN order
+    AD1CON1bits.SSRC = 0b111; // convert as soon as the sampling time is over
+    AD1CON1bits.ASAM = 1; // start sampling again right after every conversion
+    AD1CON2bits.CSCNA = 1; // scan the inputs in AD1CSSL
+    AD1CON2bits.BUFM = 1; // two 8 word buffers, one is read while the other fills
+    AD1CON2bits.SMPI = adc_scan_count - 1; // interrupt after every pass of the scan list
+    AD1CON3bits.ADRC = 0; // Tad from the peripheral clock
+    AD1CON3bits.SAMC = 31; // sample for 31 Tad
+    AD1CON3bits.ADCS = adcs;
+
+    IPC5bits.AD1IP = 5; // same as IPL5SOFT in the ISR
+    IPC5bits.AD1IS = 0;
+    IFS0bits.AD1IF = 0;
+    IEC0bits.AD1IE = 1;
+    AD1CON1bits.ON = 1;
+}
+
+// back to one conversion at a time for adc_sample_convert() and ctmu_read()
+void adc_scan_stop() {
+    IEC0bits.AD1IE = 0;
+    AD1CON1bits.ON = 0;
+    AD1CON1bits.ASAM = 0;
+    AD1CON1bits.SSRC = 0b000; // clearing SAMP starts the conversion
+    AD1CON2 = 0; // no scan, one sample per interrupt, one 16 word buffer
+    AD1CON3bits.SAMC = 0;
+    AD1CON3bits.ADCS = 1; // Tad of adc_setup()
+    IFS0bits.AD1IF = 0;
+    AD1CON1bits.ON = 1;
+    adc_scan_count = 0;
+}
+
+// samples of AN pin waiting to be read
+int adc_scan_available(int pin) {
+    int slot;
+    if (pin < 0 || pin > 15 || adc_scan_count == 0 || adc_scan_slot[pin] < 0) {
+        return 0;
+    }
+    slot = adc_scan_slot[pin];
+    return adc_ring_head[slot] - adc_ring_tail[slot];
+}
+
+// oldest sample of AN pin into value, returns 0 right away if there is none
+int adc_scan_read(int pin, unsigned short * value) {
+    return adc_scan_readBlock(pin, value, 1);
+}
+
+// up to max of the oldest samples of AN pin, returns how many
+int adc_scan_readBlock(int pin, unsigned short * out, int max) {
+    int slot;
+    int n = 0;
+    unsigned int tail;
+    unsigned int head;
+    if (pin < 0 || pin > 15 || adc_scan_count == 0 || adc_scan_slot[pin] < 0) {
+        return 0;
+    }
+    slot = adc_scan_slot[pin];
+    tail = adc_ring_tail[slot];
+    head = adc_ring_head[slot];
+    while (n < max && tail != head) {
+        out[n++] = adc_ring[slot][tail & (ADC_RING_SIZE - 1)];
+        tail++;
+    }
+    adc_ring_tail[slot] = tail; // frees the slots for the ISR
+    return n;
+}
+
+// samples of AN pin the ISR had to drop since adc_scan_start()
+unsigned int adc_scan_overflows(int pin) {
+    if (pin < 0 || pin > 15 || adc_scan_count == 0 || adc_scan_slot[pin] < 0) {
+        return 0;
+    }
+    return adc_ring_overflows[adc_scan_slot[pin]];
+}
+
 void ctmu_setup() {
     // base level current is about 0.55uA
     CTMUCONbits.IRNG = 0b11; // 100 times the base level current
@@ -196,4 +645,182 @@ int ctmu_read(int pin, int delay) {
     {}
     AD1CON1bits.DONE = 0; // ADC conversion done, clear flag
     return ADC1BUF0; // Get the value from the ADC
+}
+
+// CTMU touch engine
+// Timer4 measures one electrode every CTMU_TICK_US, in three interrupts that each set up
+// when the next one comes, so the ISR never waits:
+// drain - the conversion started last time is read and filtered, that electrode is grounded,
+//         and the next one is let go and drained for CTMU_DRAIN_TICKS
+// charge - the drain ends and the charge starts, for delay core ticks
+// convert - the charge ends and the conversion starts, it is read at the next drain
+// The charge is timed with the core timer and the count scaled to delay core ticks, so a late
+// interrupt (a higher priority ISR, or a ws2812b frame holding it off) doesn't move it.
+// One that was so late the ADC is full is thrown away and the electrode measured again.
+// The electrodes that aren't being measured stay grounded through their pins, so they are
+// discharged while the others are measured and nothing has to wait the 1ms of ctmu_read().
+// The engine owns the ADC while it runs, don't use adc_sample_convert() or the scan with it.
+
+int ctmu_pins[CTMU_MAX_CHANNELS]; // AN pin of every electrode
+int ctmu_channels = 0;
+int ctmu_delay = 150; // charge time in core ticks
+int ctmu_current = -1; // electrode being converted, -1 before the first one
+volatile unsigned int ctmu_filtered[CTMU_MAX_CHANNELS]; // counts << CTMU_FILTER_SHIFT
+volatile unsigned int ctmu_scan_count = 0; // every electrode measured once more
+int ctmu_step = 0; // what the next interrupt does, CTMU_STEP_*
+unsigned int ctmu_charge_start; // core timer when the charge started
+unsigned int ctmu_charged = 1; // core ticks the last electrode really charged for
+
+#define CTMU_STEP_DRAIN 0
+#define CTMU_STEP_CHARGE 1
+#define CTMU_STEP_CONVERT 2
+
+// port (0 = A, 1 = B) and bit of AN0-AN12, -1 where there is no AN pin on the 28 pin part
+static const signed char ctmu_an_port[13] = {0, 0, 1, 1, 1, 1, -1, -1, -1, 1, 1, 1, 1};
+static const unsigned char ctmu_an_bit[13] = {0, 1, 0, 1, 2, 3, 0, 0, 0, 15, 14, 13, 12};
+
+// hold the electrode at 0V
+static void ctmu_ground(int i) {
+    unsigned int mask = 1 << ctmu_an_bit[ctmu_pins[i]];
+    if (ctmu_an_port[ctmu_pins[i]] == 0) {
+        LATACLR = mask;
+        TRISACLR = mask;
+    } else {
+        LATBCLR = mask;
+        TRISBCLR = mask;
+    }
+}
+
+// let the electrode float so the CTMU can charge it
+static void ctmu_release(int i) {
+    unsigned int mask = 1 << ctmu_an_bit[ctmu_pins[i]];
+    if (ctmu_an_port[ctmu_pins[i]] == 0) {
+        TRISASET = mask;
+    } else {
+        TRISBSET = mask;
+    }
+}
+
+// the next Timer4 interrupt in ticks 48MHz ticks
+static void ctmu_schedule(unsigned int ticks) {
+    TMR4 = 0;
+    PR4 = ticks - 1;
+}
+
+void __ISR(_TIMER_4_VECTOR, IPL4SOFT) ctmu_isr(void) {
+    unsigned int raw;
+
+    IFS0bits.T4IF = 0; // first, a short step can match again before the ISR is done
+
+    if (ctmu_step == CTMU_STEP_CHARGE) {
+        CTMUCONbits.IDISSEN = 0; // End drain of circuit
+        CTMUCONbits.EDG1STAT = 1; // Begin charging the circuit
+        ctmu_charge_start = _CP0_GET_COUNT();
+        ctmu_schedule(2 * ctmu_delay); // 2 Timer4 ticks per core tick
+        ctmu_step = CTMU_STEP_CONVERT;
+        return;
+    }
+    if (ctmu_step == CTMU_STEP_CONVERT) {
+        AD1CON1bits.SAMP = 0; // Begin analog-to-digital conversion, read at the next drain
+        CTMUCONbits.EDG1STAT = 0; // Stop charging circuit
+        ctmu_charged = _CP0_GET_COUNT() - ctmu_charge_start;
+        ctmu_schedule(48 * CTMU_TICK_US - 2 * CTMU_DRAIN_TICKS - 2 * ctmu_delay); // rest of the tick
+        ctmu_step = CTMU_STEP_DRAIN;
+        return;
+    }
+
+    // finish the electrode converted since the last tick
+    if (ctmu_current >= 0) {
+        raw = ADC1BUF0;
+        if (raw < 1023 && ctmu_charged < 2 * ctmu_delay) {
+            raw = raw * ctmu_delay / ctmu_charged; // the count delay core ticks of charge give
+            ctmu_filtered[ctmu_current] += raw - (ctmu_filtered[ctmu_current] >> CTMU_FILTER_SHIFT);
+            ctmu_ground(ctmu_current);
+            ctmu_current++;
+            if (ctmu_current == ctmu_channels) {
+                ctmu_current = 0;
+                ctmu_scan_count++;
+            }
+        } // else charged too long, the drain below starts it over
+    } else {
+        ctmu_current = 0;
+    }
+
+    // start the next one
+    ctmu_release(ctmu_current);
+    AD1CHSbits.CH0SA = ctmu_pins[ctmu_current];
+    AD1CON1bits.SAMP = 1; // Manual sampling start
+    CTMUCONbits.IDISSEN = 1; // drain the sample and hold cap and what is left on the pin
+    ctmu_schedule(2 * CTMU_DRAIN_TICKS);
+    ctmu_step = CTMU_STEP_CHARGE;
+}
+
+// measure the electrodes on AN pins[0..numPins-1] in the background, charging each for delay core ticks
+// call ctmu_setup() and adc_setup() first
+void ctmu_start(const int * pins, int numPins, int delay) {
+    int i;
+    ctmu_stop();
+    if (numPins > CTMU_MAX_CHANNELS) {
+        numPins = CTMU_MAX_CHANNELS;
+    }
+    ctmu_channels = 0;
+    for (i = 0; i < numPins; i++) {
+        if (pins[i] >= 0 && pins[i] <= 12 && ctmu_an_port[pins[i]] >= 0) {
+            ctmu_pins[ctmu_channels] = pins[i];
+            ctmu_filtered[ctmu_channels] = 0;
+            ctmu_ground(ctmu_channels);
+            ctmu_channels++;
+        }
+    }
+    if (ctmu_channels == 0) {
+        return;
+    }
+    if (delay < 1) {
+        delay = 1;
+    }
+    if (delay > CTMU_MAX_DELAY) {
+        delay = CTMU_MAX_DELAY;
+    }
+    ctmu_delay = delay;
+    ctmu_current = -1;
+    ctmu_scan_count = 0;
+    ctmu_step = CTMU_STEP_DRAIN;
+
+    T4CON = 0;
+    T4CONbits.TCKPS = 0; // Timer4 prescaler N=1 (1:1)
+    PR4 = 48 * CTMU_TICK_US - 1;
+    TMR4 = 0;
+    IPC4bits.T4IP = 4; // same as IPL4SOFT in the ISR
+    IPC4bits.T4IS = 0;
+    IFS0bits.T4IF = 0;
+    IEC0bits.T4IE = 1;
+    T4CONbits.ON = 1;
+}
+
+// stop the engine and leave the electrodes floating for ctmu_read()
+void ctmu_stop() {
+    int i;
+    T4CONbits.ON = 0;
+    IEC0bits.T4IE = 0;
+    IFS0bits.T4IF = 0;
+    CTMUCONbits.EDG1STAT = 0;
+    CTMUCONbits.IDISSEN = 0;
+    AD1CON1bits.SAMP = 0;
+    for (i = 0; i < ctmu_channels; i++) {
+        ctmu_release(i);
+    }
+    ctmu_channels = 0;
+}
+
+// filtered ADC count of electrode i (its place in the pins given to ctmu_start()), lower when touched
+int ctmu_count(int i) {
+    if (i < 0 || i >= ctmu_channels) {
+        return 0;
+    }
+    return ctmu_filtered[i] >> CTMU_FILTER_SHIFT;
+}
+
+// how many times every electrode has been measured since ctmu_start()
+unsigned int ctmu_scans() {
+    return ctmu_scan_count;
 }
\ No newline at end of file
@@ -0,0 +1,78 @@
+#ifndef DSP_H__
+#define DSP_H__
+
+#include <xc.h>
+
+// Fixed point filters for sensor samples.
+// Q15 is a short with 15 fraction bits, -1 to 0.99997. Products are summed in a long long,
+// written as acc += (long long)a * b, which XC32 turns into one MADD (or MSUB for -=) into
+// the HI/LO accumulator per tap at -O1 and up, so a tap costs a load pair and a MADD.
+// dsp.c asks for -O1 itself with #pragma GCC optimize, the project is built at -O0.
+// Every filter has a block function. They take short samples, except dsp_fir32_block() which
+// takes Q31 ints. dsp_fromAdc() turns the unsigned ADC samples of adc_stream_get() or
+// adc_scan_readBlock() into Q15 first.
+// test/test_dsp.c checks every filter against double precision on the PC.
+
+#define Q15(x) ((short)((x) >= 0.99997 ? 32767 : (x) * 32768.0 + ((x) >= 0 ? 0.5 : -0.5)))
+#define Q14(x) ((short)((x) * 16384.0 + ((x) >= 0 ? 0.5 : -0.5))) // -2 to 2, for biquads
+
+void dsp_fromAdc(const unsigned short * in, short * out, int n); // 10 bit 0-1023 -> Q15 around 512
+
+// FIR, Q15 or Q31 coefficients and samples, any number of taps
+typedef struct {
+    const short * coeffs; // taps of them, coeffs[0] multiplies the newest sample
+    short * state; // 2*taps shorts, the delay line is kept twice so it never wraps
+    int taps;
+    int pos;
+} dspFir;
+void dsp_fir_init(dspFir * f, const short * coeffs, short * state, int taps);
+short dsp_fir(dspFir * f, short x);
+void dsp_fir_block(dspFir * f, const short * in, short * out, int n);
+
+typedef struct {
+    const int * coeffs;
+    int * state; // 2*taps ints
+    int taps;
+    int pos;
+} dspFir32;
+void dsp_fir32_init(dspFir32 * f, const int * coeffs, int * state, int taps);
+int dsp_fir32(dspFir32 * f, int x);
+void dsp_fir32_block(dspFir32 * f, const int * in, int * out, int n);
+
+// biquad cascade, direct form 1, y = b0 x + b1 x1 + b2 x2 - a1 y1 - a2 y2 in Q14
+typedef struct {
+    short b0, b1, b2, a1, a2;
+} dspBiquadCoeffs;
+typedef struct {
+    const dspBiquadCoeffs * coeffs; // one per section
+    short * state; // 4 shorts per section: x1 x2 y1 y2
+    int sections;
+} dspBiquad;
+void dsp_biquad_init(dspBiquad * f, const dspBiquadCoeffs * coeffs, short * state, int sections);
+short dsp_biquad(dspBiquad * f, short x);
+void dsp_biquad_block(dspBiquad * f, const short * in, short * out, int n);
+
+// moving average over 2^shift samples, one add and one subtract per sample
+typedef struct {
+    short * ring; // 2^shift shorts
+    int shift;
+    int pos;
+    int sum;
+} dspAverage;
+void dsp_average_init(dspAverage * f, short * ring, int shift);
+short dsp_average(dspAverage * f, short x);
+void dsp_average_block(dspAverage * f, const short * in, short * out, int n);
+
+// running median of an odd window up to DSP_MEDIAN_MAX, for spikes
+#define DSP_MEDIAN_MAX 15
+typedef struct {
+    short ring[DSP_MEDIAN_MAX]; // in arrival order
+    short sorted[DSP_MEDIAN_MAX];
+    int len;
+    int pos;
+} dspMedian;
+void dsp_median_init(dspMedian * f, int len);
+short dsp_median(dspMedian * f, short x);
+void dsp_median_block(dspMedian * f, const short * in, short * out, int n);
+
+#endif
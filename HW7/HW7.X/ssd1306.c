@@ -93,6 +93,9 @@ void ssd1306_clear() {
 void drawLetter(unsigned char x, unsigned char y, char character){
     //Takes x and y as the position of the character
     //Draw a letter with x & y increase gradually
+    //Bytes 128-255 aren't in the table, they draw the fallback instead of reading past it
+    unsigned char code = (unsigned char) character;
+    const unsigned char *glyph = FONT_GLYPHS[code < 128 ? FONT_INDEX[code] : FONT_SLOT_FALLBACK];
     int j;
     int k;
     int scan_y;
@@ -100,7 +103,7 @@ void drawLetter(unsigned char x, unsigned char y, char character){
     for(j=0; j <= 4; j++){
         scan_y = y;
         for(k=0; k <= 7; k++){
-            color = (ASCII[character-0x20][j]>>k) & 1;
+            color = (glyph[j]>>k) & 1;
             ssd1306_drawPixel(x,scan_y,color);
             scan_y = scan_y + 1;
         }
@@ -0,0 +1,193 @@
+// touch processing, see touch.h
+
+#include "touch.h"
+
+int touch_electrodes = 0;
+int touch_is_wheel = 0;
+int touch_base[TOUCH_MAX_ELECTRODES]; // baseline << TOUCH_BASELINE_SHIFT
+int touch_deltas[TOUCH_MAX_ELECTRODES];
+unsigned char touch_on[TOUCH_MAX_ELECTRODES];
+unsigned char touch_bounce[TOUCH_MAX_ELECTRODES]; // updates in a row that wanted the other state
+unsigned short touch_held[TOUCH_MAX_ELECTRODES]; // updates in a row an electrode has been on
+unsigned char touch_slider_on = 0;
+unsigned char touch_slider_bounce = 0;
+int touch_pos = -1; // slider position, -1 when not touched
+int touch_reported = -1; // position of the last down or move event
+
+void touch_setup(int numElectrodes, int wheel) {
+    int i;
+    if (numElectrodes > TOUCH_MAX_ELECTRODES) {
+        numElectrodes = TOUCH_MAX_ELECTRODES;
+    }
+    touch_electrodes = numElectrodes;
+    touch_is_wheel = wheel;
+    for (i = 0; i < TOUCH_MAX_ELECTRODES; i++) {
+        touch_base[i] = 0;
+        touch_deltas[i] = 0;
+        touch_on[i] = 0;
+        touch_bounce[i] = 0;
+        touch_held[i] = 0;
+    }
+    touch_slider_on = 0;
+    touch_slider_bounce = 0;
+    touch_pos = -1;
+    touch_reported = -1;
+}
+
+void touch_calibrate(const int * counts) {
+    int i;
+    for (i = 0; i < touch_electrodes; i++) {
+        touch_base[i] = counts[i] << TOUCH_BASELINE_SHIFT;
+        touch_deltas[i] = 0;
+        touch_on[i] = 0;
+        touch_bounce[i] = 0;
+        touch_held[i] = 0;
+    }
+}
+
+// change *on once want has been different from it TOUCH_DEBOUNCE updates in a row
+// returns 1 if it changed
+static int touch_debounce(unsigned char * on, unsigned char * bounce, int want) {
+    if (want == *on) {
+        *bounce = 0;
+        return 0;
+    }
+    (*bounce)++;
+    if (*bounce < TOUCH_DEBOUNCE) {
+        return 0;
+    }
+    *on = want;
+    *bounce = 0;
+    return 1;
+}
+
+// centroid of the deltas, total is their sum and isn't 0
+static int touch_centroid(int total) {
+    int i, m, prev, next, pos;
+    int sum = 0;
+
+    if (!touch_is_wheel) {
+        // electrode i is at i*TOUCH_POS_SCALE
+        for (i = 1; i < touch_electrodes; i++) {
+            sum += i * touch_deltas[i];
+        }
+        return sum * TOUCH_POS_SCALE / total;
+    }
+
+    // on a wheel the ends meet, so only the strongest electrode and its two neighbors count
+    m = 0;
+    for (i = 1; i < touch_electrodes; i++) {
+        if (touch_deltas[i] > touch_deltas[m]) {
+            m = i;
+        }
+    }
+    prev = touch_deltas[(m + touch_electrodes - 1) % touch_electrodes];
+    next = touch_deltas[(m + 1) % touch_electrodes];
+    sum = prev + touch_deltas[m] + next;
+    if (sum == 0) {
+        return m * TOUCH_POS_SCALE;
+    }
+    pos = m * TOUCH_POS_SCALE + (next - prev) * TOUCH_POS_SCALE / sum;
+    if (pos < 0) {
+        pos += touch_electrodes * TOUCH_POS_SCALE;
+    }
+    if (pos >= touch_electrodes * TOUCH_POS_SCALE) {
+        pos -= touch_electrodes * TOUCH_POS_SCALE;
+    }
+    return pos;
+}
+
+int touch_update(const int * counts) {
+    int i, d, baseline, want, changed, move;
+    int total = 0;
+    int event = TOUCH_EVENT_NONE;
+
+    for (i = 0; i < touch_electrodes; i++) {
+        baseline = touch_base[i] >> TOUCH_BASELINE_SHIFT;
+        d = baseline - counts[i];
+        if (d < 0) {
+            // count above the baseline, nothing is touching it and the baseline is behind
+            touch_base[i] += ((counts[i] << TOUCH_BASELINE_SHIFT) - touch_base[i]) >> TOUCH_RECOVER_SHIFT;
+            d = 0;
+        } else if (!touch_on[i]) {
+            // IIR, base/2^shift moves 1/2^shift of the way to the count, frozen while touched
+            touch_base[i] += counts[i] - baseline;
+        }
+
+        if (touch_on[i]) {
+            touch_held[i]++;
+            if (touch_held[i] >= TOUCH_MAX_ON) {
+                // stuck on, the baseline was frozen while the count drifted away
+                touch_base[i] = counts[i] << TOUCH_BASELINE_SHIFT;
+                touch_on[i] = 0;
+                touch_bounce[i] = 0;
+                d = 0;
+            }
+        } else {
+            touch_held[i] = 0;
+        }
+        touch_deltas[i] = d;
+        total += d;
+
+        want = touch_on[i] ? (d >= TOUCH_OFF) : (d > TOUCH_ON);
+        touch_debounce(&touch_on[i], &touch_bounce[i], want);
+    }
+
+    want = touch_slider_on ? (total >= TOUCH_SLIDER_OFF) : (total > TOUCH_SLIDER_ON);
+    changed = touch_debounce(&touch_slider_on, &touch_slider_bounce, want);
+    if (!touch_slider_on) {
+        touch_pos = -1;
+        if (changed) {
+            event = TOUCH_EVENT_UP;
+        }
+        return event;
+    }
+
+    if (total > 0) {
+        touch_pos = touch_centroid(total);
+    }
+    if (changed) {
+        touch_reported = touch_pos;
+        return TOUCH_EVENT_DOWN;
+    }
+    move = touch_pos - touch_reported;
+    if (touch_is_wheel) {
+        // the short way around
+        if (move > touch_electrodes * TOUCH_POS_SCALE / 2) {
+            move -= touch_electrodes * TOUCH_POS_SCALE;
+        }
+        if (move < -touch_electrodes * TOUCH_POS_SCALE / 2) {
+            move += touch_electrodes * TOUCH_POS_SCALE;
+        }
+    }
+    if (move >= TOUCH_MOVE_MIN || move <= -TOUCH_MOVE_MIN) {
+        touch_reported = touch_pos;
+        event = TOUCH_EVENT_MOVE;
+    }
+    return event;
+}
+
+int touch_isTouched(int i) {
+    if (i < 0 || i >= touch_electrodes) {
+        return 0;
+    }
+    return touch_on[i];
+}
+
+int touch_delta(int i) {
+    if (i < 0 || i >= touch_electrodes) {
+        return 0;
+    }
+    return touch_deltas[i];
+}
+
+int touch_baseline(int i) {
+    if (i < 0 || i >= touch_electrodes) {
+        return 0;
+    }
+    return touch_base[i] >> TOUCH_BASELINE_SHIFT;
+}
+
+int touch_position() {
+    return touch_pos;
+}
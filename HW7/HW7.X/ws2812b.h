@@ -10,8 +10,72 @@ typedef struct {
     unsigned char b;
 } wsColor; 
 
+// 16 bit linear color for the output stage
+typedef struct {
+    unsigned short r;
+    unsigned short g;
+    unsigned short b;
+} wsColor16;
+
+#define WS2812B_MAX_LEDS 64 // most LEDs the buffered output modes can hold
+#define WS2812B_BYTES_PER_LED 3 // RAM per LED of ws2812b_setColor(), just the wsColor
+#define WS2812B_SPI_BYTES_PER_LED 12 // 24 color bits * 4 SPI bits
+#define WS2812B_PAR_BYTES_PER_LED 24 // one bit slice byte per color bit
+#define WS2812B_PAR_MAX_STRIPS 8
+#define WS2812B_TOO_MANY (-1) // more than WS2812B_MAX_LEDS for a mode that has to hold them
+
+// The bit banged modes (setColor*, par_setColor and show) hold off the CTMU engine's Timer4
+// interrupt while the bits are on the wire, 30uS per LED, so it can't stretch a high. The ADC
+// scan and stream interrupts stay on: holding them off for a frame of N LEDs would delay them
+// N * 30uS and overrun their buffers on a long strip. They are short, but one that lands in a
+// high still stretches it, so use the SPI or OC mode while adc_scan or adc_stream runs.
 void ws2812b_setup();
-void ws2812b_setColor(wsColor*,int);
+int ws2812b_setColor(wsColor*,int); // 0 if the frame didn't change and wasn't sent
+void ws2812b_setRefresh(unsigned int ms); // resend an unchanged frame after ms, 0 to always send
+void ws2812b_invalidate(); // send the next frame even if it didn't change
+
+// compact frames, expanded to wire bits only while they are sent, any numLEDs
+#define WS2812B_PAL4_BYTES(n) (((n) + 1) / 2) // pixel bytes of a 4 bit frame
+int ws2812b_setColor565(const unsigned short * px, int numLEDs); // 2 bytes/LED, rrrrrggggggbbbbb
+int ws2812b_setColorPal8(const unsigned char * px, const wsColor * palette, int numLEDs); // 1 byte/LED, 256 colors
+int ws2812b_setColorPal4(const unsigned char * px, const wsColor * palette, int numLEDs); // 2 LEDs/byte, 16 colors, even LED in the low nibble
+
+// SPI + DMA output mode, SDO1 on B6
+// The frame is encoded into a buffer of WS2812B_MAX_LEDS LEDs. Longer frames aren't cut short,
+// nothing is encoded or sent and both return WS2812B_TOO_MANY.
+void ws2812b_spi_setup();
+int ws2812b_spi_encode(wsColor * c, int numLEDs, unsigned char * buf); // bytes to send
+int ws2812b_spi_setColor(wsColor*,int); // 1 if sent
+int ws2812b_spi_busy();
+
+// Output compare + DMA output mode, OC4 on B6. Uses the DMA channel 1 interrupt (IPL3) to stop
+// OC4 and Timer2 at the end of every frame
+// The edge table holds WS2812B_MAX_LEDS LEDs. Longer frames aren't cut short, nothing is
+// encoded or sent and both return WS2812B_TOO_MANY.
+void ws2812b_oc_setup();
+int ws2812b_oc_encode(wsColor * c, int numLEDs); // table entries
+int ws2812b_oc_setColor(wsColor*,int); // 1 if sent, 0 for no LEDs
+int ws2812b_oc_busy();
+
+// Parallel output mode, up to WS2812B_PAR_MAX_STRIPS strips on neighboring LATB pins
+// The bit slices hold WS2812B_MAX_LEDS LEDs per strip. Longer frames aren't cut short,
+// nothing is encoded or sent and both return WS2812B_TOO_MANY.
+void ws2812b_par_setup(int firstPin, int numStrips);
+int ws2812b_par_encode(wsColor ** strips, int numLEDs); // bit slices
+int ws2812b_par_setColor(wsColor ** strips, int numLEDs); // 1 if sent, 0 for no LEDs or strips
 wsColor HSBtoRGB(float hue, float sat, float brightness);
 
+// output stage: gamma, global brightness (0 to 256) and temporal dithering, then ws2812b_setColor()
+// The dither leftovers of every LED are kept between frames, for up to WS2812B_MAX_LEDS LEDs.
+// Longer frames aren't cut short, nothing is sent and they return WS2812B_TOO_MANY.
+void ws2812b_setBrightness(unsigned short brightness);
+int ws2812b_show(wsColor * c, int numLEDs); // 1 if sent, 0 if unchanged, WS2812B_TOO_MANY
+int ws2812b_show16(wsColor16 * c, int numLEDs);
+
+// integer color wheel, hue 0 to HSB_HUE_MAX-1, sat and brightness 0 to 255
+// within 2 LSB of HSBtoRGB() on every channel, test/test_hsb.c checks it on the PC
+#define HSB_HUE_MAX 1536 // 6 * 256
+wsColor HSBtoRGB_fixed(unsigned int hue, unsigned char sat, unsigned char brightness);
+void HSBtoRGB_rainbow(wsColor * c, int numLEDs, unsigned int hue, unsigned char sat, unsigned char brightness);
+
 #endif
\ No newline at end of file
@@ -5,8 +5,38 @@
 
 void adc_setup();
 unsigned int adc_sample_convert(int pin);
+unsigned int adc_oversample(int pin, int n); // 4^n samples -> 10+n bits, n 1 to 4
+
+// auto scan into a ring per channel, reads never wait
+#define ADC_SCAN_MAX 8 // channels in the scan list, one half of the ADC buffer
+#define ADC_RING_SIZE 64 // samples per channel, has to be a power of 2
+void adc_scan_start(unsigned int mask, unsigned char adcs); // mask bit n is ANn
+void adc_scan_stop();
+int adc_scan_available(int pin);
+int adc_scan_read(int pin, unsigned short * value); // 1 if there was a sample
+int adc_scan_readBlock(int pin, unsigned short * out, int max);
+unsigned int adc_scan_overflows(int pin);
+
+// Timer3 triggered sampling of one pin into a DMA ping-pong buffer
+#define ADC_STREAM_BLOCK 128 // samples per block, two blocks
+#define ADC_STREAM_MAX_RATE 200000 // samples per second
+void adc_stream_start(int pin, unsigned int rate);
+void adc_stream_stop();
+unsigned short * adc_stream_get(); // next full block or 0, good until the DMA comes around again
+unsigned int adc_stream_overrunCount();
 
 void ctmu_setup();
 int ctmu_read(int pin, int delay);
 
+// touch engine, Timer4 measures one electrode per tick in the background
+#define CTMU_MAX_CHANNELS 4
+#define CTMU_TICK_US 250 // one electrode per tick, 2 electrodes -> 2000 scans/s
+#define CTMU_DRAIN_TICKS 24 // core ticks of IDISSEN before charging, 1uS
+#define CTMU_MAX_DELAY (CTMU_TICK_US * 24 / 2) // longest charge in core ticks, half a tick
+#define CTMU_FILTER_SHIFT 3 // counts are averaged over about 2^3 scans
+void ctmu_start(const int * pins, int numPins, int delay);
+void ctmu_stop();
+int ctmu_count(int i);
+unsigned int ctmu_scans();
+
 #endif
\ No newline at end of file
@@ -0,0 +1,223 @@
+// fixed point filters, see dsp.h
+
+// The MPLAB project builds at -O0, where a long long multiply-add is a call to __muldi3 and
+// an add with carry instead of one MADD. This file is built at -O1 whatever the project says.
+#pragma GCC optimize("O1")
+
+#include "dsp.h"
+
+// clip to a short
+static short dsp_sat(int x) {
+    if (x > 32767) {
+        return 32767;
+    }
+    if (x < -32768) {
+        return -32768;
+    }
+    return x;
+}
+
+void dsp_fromAdc(const unsigned short * in, short * out, int n) {
+    int i;
+    for (i = 0; i < n; i++) {
+        out[i] = ((int) in[i] - 512) << 6;
+    }
+}
+
+void dsp_fir_init(dspFir * f, const short * coeffs, short * state, int taps) {
+    int i;
+    f->coeffs = coeffs;
+    f->state = state;
+    f->taps = taps;
+    f->pos = 0;
+    for (i = 0; i < 2 * taps; i++) {
+        state[i] = 0;
+    }
+}
+
+short dsp_fir(dspFir * f, short x) {
+    const short * h = f->coeffs;
+    const short * s;
+    long long acc = 0;
+    int i;
+
+    // newest sample goes in front of the last one, in both copies of the delay line
+    f->pos = (f->pos == 0) ? f->taps - 1 : f->pos - 1;
+    f->state[f->pos] = x;
+    f->state[f->pos + f->taps] = x;
+    s = &f->state[f->pos]; // s[0] newest ... s[taps-1] oldest, never wraps
+
+    for (i = 0; i < f->taps; i++) {
+        acc += (long long) h[i] * s[i]; // MADD
+    }
+    return dsp_sat(acc >> 15);
+}
+
+void dsp_fir_block(dspFir * f, const short * in, short * out, int n) {
+    int i;
+    for (i = 0; i < n; i++) {
+        out[i] = dsp_fir(f, in[i]);
+    }
+}
+
+void dsp_fir32_init(dspFir32 * f, const int * coeffs, int * state, int taps) {
+    int i;
+    f->coeffs = coeffs;
+    f->state = state;
+    f->taps = taps;
+    f->pos = 0;
+    for (i = 0; i < 2 * taps; i++) {
+        state[i] = 0;
+    }
+}
+
+int dsp_fir32(dspFir32 * f, int x) {
+    const int * h = f->coeffs;
+    const int * s;
+    long long acc = 0;
+    int i;
+
+    f->pos = (f->pos == 0) ? f->taps - 1 : f->pos - 1;
+    f->state[f->pos] = x;
+    f->state[f->pos + f->taps] = x;
+    s = &f->state[f->pos];
+
+    for (i = 0; i < f->taps; i++) {
+        acc += (long long) h[i] * s[i]; // MADD, 32x32 -> 64
+    }
+    acc >>= 31;
+    if (acc > 0x7FFFFFFF) {
+        return 0x7FFFFFFF;
+    }
+    if (acc < -0x7FFFFFFF - 1) {
+        return -0x7FFFFFFF - 1;
+    }
+    return acc;
+}
+
+void dsp_fir32_block(dspFir32 * f, const int * in, int * out, int n) {
+    int i;
+    for (i = 0; i < n; i++) {
+        out[i] = dsp_fir32(f, in[i]);
+    }
+}
+
+void dsp_biquad_init(dspBiquad * f, const dspBiquadCoeffs * coeffs, short * state, int sections) {
+    int i;
+    f->coeffs = coeffs;
+    f->state = state;
+    f->sections = sections;
+    for (i = 0; i < 4 * sections; i++) {
+        state[i] = 0;
+    }
+}
+
+short dsp_biquad(dspBiquad * f, short x) {
+    const dspBiquadCoeffs * c = f->coeffs;
+    short * s = f->state;
+    long long acc;
+    short y;
+    int i;
+
+    for (i = 0; i < f->sections; i++) {
+        acc = (long long) c->b0 * x;
+        acc += (long long) c->b1 * s[0]; // MADD
+        acc += (long long) c->b2 * s[1];
+        acc -= (long long) c->a1 * s[2]; // MSUB
+        acc -= (long long) c->a2 * s[3];
+        y = dsp_sat(acc >> 14);
+        s[1] = s[0];
+        s[0] = x;
+        s[3] = s[2];
+        s[2] = y;
+        x = y; // into the next section
+        c++;
+        s += 4;
+    }
+    return x;
+}
+
+void dsp_biquad_block(dspBiquad * f, const short * in, short * out, int n) {
+    int i;
+    for (i = 0; i < n; i++) {
+        out[i] = dsp_biquad(f, in[i]);
+    }
+}
+
+void dsp_average_init(dspAverage * f, short * ring, int shift) {
+    int i;
+    f->ring = ring;
+    f->shift = shift;
+    f->pos = 0;
+    f->sum = 0;
+    for (i = 0; i < (1 << shift); i++) {
+        ring[i] = 0;
+    }
+}
+
+short dsp_average(dspAverage * f, short x) {
+    f->sum += x - f->ring[f->pos];
+    f->ring[f->pos] = x;
+    f->pos = (f->pos + 1) & ((1 << f->shift) - 1);
+    return f->sum >> f->shift;
+}
+
+void dsp_average_block(dspAverage * f, const short * in, short * out, int n) {
+    int i;
+    for (i = 0; i < n; i++) {
+        out[i] = dsp_average(f, in[i]);
+    }
+}
+
+void dsp_median_init(dspMedian * f, int len) {
+    int i;
+    if (len > DSP_MEDIAN_MAX) {
+        len = DSP_MEDIAN_MAX;
+    }
+    if (len < 1) {
+        len = 1;
+    }
+    f->len = len | 1; // odd, so there is a middle
+    f->pos = 0;
+    for (i = 0; i < DSP_MEDIAN_MAX; i++) {
+        f->ring[i] = 0;
+        f->sorted[i] = 0;
+    }
+}
+
+// the oldest sample comes out of the sorted window and the new one goes in, one pass
+short dsp_median(dspMedian * f, short x) {
+    short old = f->ring[f->pos];
+    int i;
+
+    f->ring[f->pos] = x;
+    f->pos++;
+    if (f->pos == f->len) {
+        f->pos = 0;
+    }
+
+    // find the old sample
+    for (i = 0; i < f->len; i++) {
+        if (f->sorted[i] == old) {
+            break;
+        }
+    }
+    // slide towards where the new one belongs, filling the hole
+    while (i > 0 && f->sorted[i - 1] > x) {
+        f->sorted[i] = f->sorted[i - 1];
+        i--;
+    }
+    while (i < f->len - 1 && f->sorted[i + 1] < x) {
+        f->sorted[i] = f->sorted[i + 1];
+        i++;
+    }
+    f->sorted[i] = x;
+    return f->sorted[f->len / 2];
+}
+
+void dsp_median_block(dspMedian * f, const short * in, short * out, int n) {
+    int i;
+    for (i = 0; i < n; i++) {
+        out[i] = dsp_median(f, in[i]);
+    }
+}
@@ -0,0 +1,150 @@
+// fixed point FFT, see fft.h
+
+#include "fft.h"
+#include "ssd1306.h"
+
+// sin(2 pi i / FFT_MAX_N) in Q15 for the first quarter of the circle
+static const short fft_quarter[FFT_MAX_N / 4 + 1] = {
+        0,   402,   804,  1206,  1608,  2009,  2411,  2811,
+     3212,  3612,  4011,  4410,  4808,  5205,  5602,  5998,
+     6393,  6787,  7180,  7571,  7962,  8351,  8740,  9127,
+     9512,  9896, 10279, 10660, 11039, 11417, 11793, 12167,
+    12540, 12910, 13279, 13646, 14010, 14373, 14733, 15091,
+    15447, 15800, 16151, 16500, 16846, 17190, 17531, 17869,
+    18205, 18538, 18868, 19195, 19520, 19841, 20160, 20475,
+    20788, 21097, 21403, 21706, 22006, 22302, 22595, 22884,
+    23170, 23453, 23732, 24008, 24279, 24548, 24812, 25073,
+    25330, 25583, 25833, 26078, 26320, 26557, 26791, 27020,
+    27246, 27467, 27684, 27897, 28106, 28311, 28511, 28707,
+    28899, 29086, 29269, 29448, 29622, 29792, 29957, 30118,
+    30274, 30425, 30572, 30715, 30853, 30986, 31114, 31238,
+    31357, 31471, 31581, 31686, 31786, 31881, 31972, 32058,
+    32138, 32214, 32286, 32352, 32413, 32470, 32522, 32568,
+    32610, 32647, 32679, 32706, 32729, 32746, 32758, 32766,
+    32767
+};
+
+// sin(2 pi t / FFT_MAX_N), t 0 to FFT_MAX_N-1, from the quarter table
+static short fft_sin(int t) {
+    if (t < FFT_MAX_N / 4) {
+        return fft_quarter[t];
+    }
+    if (t < FFT_MAX_N / 2) {
+        return fft_quarter[FFT_MAX_N / 2 - t];
+    }
+    if (t < 3 * FFT_MAX_N / 4) {
+        return -fft_quarter[t - FFT_MAX_N / 2];
+    }
+    return -fft_quarter[FFT_MAX_N - t];
+}
+
+static short fft_cos(int t) {
+    return fft_sin((t + FFT_MAX_N / 4) & (FFT_MAX_N - 1));
+}
+
+void fft(short * re, short * im, int log2n) {
+    int n = 1 << log2n;
+    int i, j, k, bit, len, half, tstep;
+    int wr, wi, tr, ti;
+    short t;
+
+    // bit reversed order first, then the butterflies work in place
+    j = 0;
+    for (i = 0; i < n - 1; i++) {
+        if (i < j) {
+            t = re[i];
+            re[i] = re[j];
+            re[j] = t;
+            t = im[i];
+            im[i] = im[j];
+            im[j] = t;
+        }
+        bit = n >> 1;
+        while (j & bit) {
+            j ^= bit;
+            bit >>= 1;
+        }
+        j |= bit;
+    }
+
+    for (len = 2; len <= n; len <<= 1) {
+        half = len >> 1;
+        tstep = FFT_MAX_N / len; // table steps per twiddle at this stage
+        for (j = 0; j < half; j++) {
+            wr = fft_cos(j * tstep);
+            wi = -fft_sin(j * tstep); // e^(-i 2 pi j / len)
+            for (i = j; i < n; i += len) {
+                k = i + half;
+                tr = (wr * re[k] - wi * im[k]) >> 15;
+                ti = (wr * im[k] + wi * re[k]) >> 15;
+                // halve every stage so the sums stay in 16 bits
+                re[k] = (re[i] - tr) >> 1;
+                im[k] = (im[i] - ti) >> 1;
+                re[i] = (re[i] + tr) >> 1;
+                im[i] = (im[i] + ti) >> 1;
+            }
+        }
+    }
+}
+
+// w = (1 - cos(2 pi i / n)) / 2, so the ends of the block don't make a step
+void fft_window(short * x, int log2n) {
+    int n = 1 << log2n;
+    int step = FFT_MAX_N >> log2n;
+    int i;
+    for (i = 0; i < n; i++) {
+        x[i] = (x[i] * ((32767 - fft_cos(i * step)) >> 1)) >> 15;
+    }
+}
+
+// |z| ~ max + 3/8 min of |re|, |im|, within about 7%, no square root
+void fft_magnitude(const short * re, const short * im, unsigned short * mag, int bins) {
+    int i, a, b;
+    for (i = 0; i < bins; i++) {
+        a = re[i] < 0 ? -re[i] : re[i];
+        b = im[i] < 0 ? -im[i] : im[i];
+        if (a < b) {
+            mag[i] = b + ((a * 3) >> 3);
+        } else {
+            mag[i] = a + ((b * 3) >> 3);
+        }
+    }
+}
+
+// 2 rows per doubling of the magnitude, the whole 16 bits fit in the 32 rows
+static int fft_barHeight(unsigned int m) {
+    int b;
+    if (m == 0) {
+        return 0;
+    }
+    b = 31 - __builtin_clz(m); // log2
+    if (b == 0) {
+        return 1;
+    }
+    return 2 * b + ((m >> (b - 1)) & 1);
+}
+
+void fft_drawBars(const unsigned short * mag, int bins) {
+    unsigned char x, y;
+    int i, first, last, h;
+    unsigned int m;
+
+    for (x = 0; x < 128; x++) {
+        // loudest bin that falls in this column
+        first = x * bins / 128;
+        last = (x + 1) * bins / 128;
+        if (last <= first) {
+            last = first + 1;
+        }
+        m = 0;
+        for (i = first; i < last; i++) {
+            if (mag[i] > m) {
+                m = mag[i];
+            }
+        }
+        h = fft_barHeight(m);
+        for (y = 0; y < 32; y++) {
+            ssd1306_drawPixel(x, y, y >= 32 - h);
+        }
+    }
+}
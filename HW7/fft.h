@@ -0,0 +1,20 @@
+#ifndef FFT_H__
+#define FFT_H__
+
+#include <xc.h>
+
+// Fixed point FFT for spectra of ADC or IMU sample blocks.
+// Radix-2, in place, Q15 real and imaginary arrays. Every stage halves the values so
+// nothing can overflow, the result is the DFT / n. Twiddles come from a quarter sine
+// table of FFT_MAX_N/4+1 entries, every smaller size uses every 2nd, 4th, ... entry.
+// test/test_fft.c checks every size against a double precision DFT on the PC.
+
+#define FFT_MAX_LOG2 9
+#define FFT_MAX_N (1 << FFT_MAX_LOG2) // 512 points, 64 to 512 work
+
+void fft(short * re, short * im, int log2n);
+void fft_window(short * x, int log2n); // Hann window, before fft()
+void fft_magnitude(const short * re, const short * im, unsigned short * mag, int bins); // alpha max + beta min
+void fft_drawBars(const unsigned short * mag, int bins); // log bars over the whole 128x32 OLED
+
+#endif
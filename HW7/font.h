@@ -1,109 +1,984 @@
 #ifndef FONT_H__
 #define FONT_H__
 
-// make these functions:
-// void drawChar(...);
-// void drawString(...);
-
-// lookup table for all of the ascii characters
-static const char ASCII[96][5] = {
- {0x00, 0x00, 0x00, 0x00, 0x00} // 20  (space)
-,{0x00, 0x00, 0x5f, 0x00, 0x00} // 21 !
-,{0x00, 0x07, 0x00, 0x07, 0x00} // 22 "
-,{0x14, 0x7f, 0x14, 0x7f, 0x14} // 23 #
-,{0x24, 0x2a, 0x7f, 0x2a, 0x12} // 24 $
-,{0x23, 0x13, 0x08, 0x64, 0x62} // 25 %
-,{0x36, 0x49, 0x55, 0x22, 0x50} // 26 &
-,{0x00, 0x05, 0x03, 0x00, 0x00} // 27 '
-,{0x00, 0x1c, 0x22, 0x41, 0x00} // 28 (
-,{0x00, 0x41, 0x22, 0x1c, 0x00} // 29 )
-,{0x14, 0x08, 0x3e, 0x08, 0x14} // 2a *
-,{0x08, 0x08, 0x3e, 0x08, 0x08} // 2b +
-,{0x00, 0x50, 0x30, 0x00, 0x00} // 2c ,
-,{0x08, 0x08, 0x08, 0x08, 0x08} // 2d -
-,{0x00, 0x60, 0x60, 0x00, 0x00} // 2e .
-,{0x20, 0x10, 0x08, 0x04, 0x02} // 2f /
-,{0x3e, 0x51, 0x49, 0x45, 0x3e} // 30 0
-,{0x00, 0x42, 0x7f, 0x40, 0x00} // 31 1
-,{0x42, 0x61, 0x51, 0x49, 0x46} // 32 2
-,{0x21, 0x41, 0x45, 0x4b, 0x31} // 33 3
-,{0x18, 0x14, 0x12, 0x7f, 0x10} // 34 4
-,{0x27, 0x45, 0x45, 0x45, 0x39} // 35 5
-,{0x3c, 0x4a, 0x49, 0x49, 0x30} // 36 6
-,{0x01, 0x71, 0x09, 0x05, 0x03} // 37 7
-,{0x36, 0x49, 0x49, 0x49, 0x36} // 38 8
-,{0x06, 0x49, 0x49, 0x29, 0x1e} // 39 9
-,{0x00, 0x36, 0x36, 0x00, 0x00} // 3a :
-,{0x00, 0x56, 0x36, 0x00, 0x00} // 3b ;
-,{0x08, 0x14, 0x22, 0x41, 0x00} // 3c <
-,{0x14, 0x14, 0x14, 0x14, 0x14} // 3d =
-,{0x00, 0x41, 0x22, 0x14, 0x08} // 3e >
-,{0x02, 0x01, 0x51, 0x09, 0x06} // 3f ?
-,{0x32, 0x49, 0x79, 0x41, 0x3e} // 40 @
-,{0x7e, 0x11, 0x11, 0x11, 0x7e} // 41 A
-,{0x7f, 0x49, 0x49, 0x49, 0x36} // 42 B
-,{0x3e, 0x41, 0x41, 0x41, 0x22} // 43 C
-,{0x7f, 0x41, 0x41, 0x22, 0x1c} // 44 D
-,{0x7f, 0x49, 0x49, 0x49, 0x41} // 45 E
-,{0x7f, 0x09, 0x09, 0x09, 0x01} // 46 F
-,{0x3e, 0x41, 0x49, 0x49, 0x7a} // 47 G
-,{0x7f, 0x08, 0x08, 0x08, 0x7f} // 48 H
-,{0x00, 0x41, 0x7f, 0x41, 0x00} // 49 I
-,{0x20, 0x40, 0x41, 0x3f, 0x01} // 4a J
-,{0x7f, 0x08, 0x14, 0x22, 0x41} // 4b K
-,{0x7f, 0x40, 0x40, 0x40, 0x40} // 4c L
-,{0x7f, 0x02, 0x0c, 0x02, 0x7f} // 4d M
-,{0x7f, 0x04, 0x08, 0x10, 0x7f} // 4e N
-,{0x3e, 0x41, 0x41, 0x41, 0x3e} // 4f O
-,{0x7f, 0x09, 0x09, 0x09, 0x06} // 50 P
-,{0x3e, 0x41, 0x51, 0x21, 0x5e} // 51 Q
-,{0x7f, 0x09, 0x19, 0x29, 0x46} // 52 R
-,{0x46, 0x49, 0x49, 0x49, 0x31} // 53 S
-,{0x01, 0x01, 0x7f, 0x01, 0x01} // 54 T
-,{0x3f, 0x40, 0x40, 0x40, 0x3f} // 55 U
-,{0x1f, 0x20, 0x40, 0x20, 0x1f} // 56 V
-,{0x3f, 0x40, 0x38, 0x40, 0x3f} // 57 W
-,{0x63, 0x14, 0x08, 0x14, 0x63} // 58 X
-,{0x07, 0x08, 0x70, 0x08, 0x07} // 59 Y
-,{0x61, 0x51, 0x49, 0x45, 0x43} // 5a Z
-,{0x00, 0x7f, 0x41, 0x41, 0x00} // 5b [
-,{0x02, 0x04, 0x08, 0x10, 0x20} // 5c ?
-,{0x00, 0x41, 0x41, 0x7f, 0x00} // 5d ]
-,{0x04, 0x02, 0x01, 0x02, 0x04} // 5e ^
-,{0x40, 0x40, 0x40, 0x40, 0x40} // 5f _
-,{0x00, 0x01, 0x02, 0x04, 0x00} // 60 `
-,{0x20, 0x54, 0x54, 0x54, 0x78} // 61 a
-,{0x7f, 0x48, 0x44, 0x44, 0x38} // 62 b
-,{0x38, 0x44, 0x44, 0x44, 0x20} // 63 c
-,{0x38, 0x44, 0x44, 0x48, 0x7f} // 64 d
-,{0x38, 0x54, 0x54, 0x54, 0x18} // 65 e
-,{0x08, 0x7e, 0x09, 0x01, 0x02} // 66 f
-,{0x0c, 0x52, 0x52, 0x52, 0x3e} // 67 g
-,{0x7f, 0x08, 0x04, 0x04, 0x78} // 68 h
-,{0x00, 0x44, 0x7d, 0x40, 0x00} // 69 i
-,{0x20, 0x40, 0x44, 0x3d, 0x00} // 6a j
-,{0x7f, 0x10, 0x28, 0x44, 0x00} // 6b k
-,{0x00, 0x41, 0x7f, 0x40, 0x00} // 6c l
-,{0x7c, 0x04, 0x18, 0x04, 0x78} // 6d m
-,{0x7c, 0x08, 0x04, 0x04, 0x78} // 6e n
-,{0x38, 0x44, 0x44, 0x44, 0x38} // 6f o
-,{0x7c, 0x14, 0x14, 0x14, 0x08} // 70 p
-,{0x08, 0x14, 0x14, 0x18, 0x7c} // 71 q
-,{0x7c, 0x08, 0x04, 0x04, 0x08} // 72 r
-,{0x48, 0x54, 0x54, 0x54, 0x20} // 73 s
-,{0x04, 0x3f, 0x44, 0x40, 0x20} // 74 t
-,{0x3c, 0x40, 0x40, 0x20, 0x7c} // 75 u
-,{0x1c, 0x20, 0x40, 0x20, 0x1c} // 76 v
-,{0x3c, 0x40, 0x30, 0x40, 0x3c} // 77 w
-,{0x44, 0x28, 0x10, 0x28, 0x44} // 78 x
-,{0x0c, 0x50, 0x50, 0x50, 0x3c} // 79 y
-,{0x44, 0x64, 0x54, 0x4c, 0x44} // 7a z
-,{0x00, 0x08, 0x36, 0x41, 0x00} // 7b {
-,{0x00, 0x00, 0x7f, 0x00, 0x00} // 7c |
-,{0x00, 0x41, 0x36, 0x08, 0x00} // 7d }
-,{0x10, 0x08, 0x08, 0x10, 0x08} // 7e ?
-,{0x00, 0x06, 0x09, 0x09, 0x06} // 7f ?
-}; // end char ASCII[96][5]
-
-
-#endif 
\ No newline at end of file
+// 5x8 font built at compile time.
+// Every glyph is written as 8 rows of 5 pixels, left pixel is the high bit.
+// FONT_GLYPH() turns the rows into the 5 column bytes drawLetter() copies into
+// ssd1306_buffer (bit 0 is the top row), so nothing is computed at run time.
+//
+// Only the groups that are turned on are stored. Turn a group off by defining
+// it to 0 before including this file, e.g. #define FONT_USE_LOWER 0.
+// A character that is not stored (or not printable) draws FONT_FALLBACK, a box.
+//
+// FONT_INDEX only covers 0-127. Use it as FONT_GLYPHS[FONT_INDEX[code]] with code an
+// unsigned char below 128, and FONT_SLOT_FALLBACK for 128-255.
+
+#ifndef FONT_USE_PUNCT
+#define FONT_USE_PUNCT 1
+#endif
+#ifndef FONT_USE_DIGITS
+#define FONT_USE_DIGITS 1
+#endif
+#ifndef FONT_USE_UPPER
+#define FONT_USE_UPPER 1
+#endif
+#ifndef FONT_USE_LOWER
+#define FONT_USE_LOWER 1
+#endif
+
+// column c of a glyph, one bit from every row
+#define FONT_COL(c, r0, r1, r2, r3, r4, r5, r6, r7) \
+    ((((r0) >> (4 - (c))) & 1) | ((((r1) >> (4 - (c))) & 1) << 1) | \
+     ((((r2) >> (4 - (c))) & 1) << 2) | ((((r3) >> (4 - (c))) & 1) << 3) | \
+     ((((r4) >> (4 - (c))) & 1) << 4) | ((((r5) >> (4 - (c))) & 1) << 5) | \
+     ((((r6) >> (4 - (c))) & 1) << 6) | ((((r7) >> (4 - (c))) & 1) << 7))
+
+// 8 rows -> 5 column bytes
+#define FONT_GLYPH(...) \
+    {FONT_COL(0, __VA_ARGS__), FONT_COL(1, __VA_ARGS__), FONT_COL(2, __VA_ARGS__), \
+     FONT_COL(3, __VA_ARGS__), FONT_COL(4, __VA_ARGS__)}
+
+#define FONT_FALLBACK \
+      0b11111, \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b11111, \
+      0b00000
+
+// space and punctuation
+#define FONT_PUNCT(X) \
+    X(0x20, /* space */ \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b00000) \
+    X(0x21, /* ! */ \
+      0b00100, \
+      0b00100, \
+      0b00100, \
+      0b00100, \
+      0b00100, \
+      0b00000, \
+      0b00100, \
+      0b00000) \
+    X(0x22, /* " */ \
+      0b01010, \
+      0b01010, \
+      0b01010, \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b00000) \
+    X(0x23, /* # */ \
+      0b01010, \
+      0b01010, \
+      0b11111, \
+      0b01010, \
+      0b11111, \
+      0b01010, \
+      0b01010, \
+      0b00000) \
+    X(0x24, /* $ */ \
+      0b00100, \
+      0b01111, \
+      0b10100, \
+      0b01110, \
+      0b00101, \
+      0b11110, \
+      0b00100, \
+      0b00000) \
+    X(0x25, /* % */ \
+      0b11000, \
+      0b11001, \
+      0b00010, \
+      0b00100, \
+      0b01000, \
+      0b10011, \
+      0b00011, \
+      0b00000) \
+    X(0x26, /* & */ \
+      0b01100, \
+      0b10010, \
+      0b10100, \
+      0b01000, \
+      0b10101, \
+      0b10010, \
+      0b01101, \
+      0b00000) \
+    X(0x27, /* ' */ \
+      0b01100, \
+      0b00100, \
+      0b01000, \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b00000) \
+    X(0x28, /* ( */ \
+      0b00010, \
+      0b00100, \
+      0b01000, \
+      0b01000, \
+      0b01000, \
+      0b00100, \
+      0b00010, \
+      0b00000) \
+    X(0x29, /* ) */ \
+      0b01000, \
+      0b00100, \
+      0b00010, \
+      0b00010, \
+      0b00010, \
+      0b00100, \
+      0b01000, \
+      0b00000) \
+    X(0x2a, /* * */ \
+      0b00000, \
+      0b00100, \
+      0b10101, \
+      0b01110, \
+      0b10101, \
+      0b00100, \
+      0b00000, \
+      0b00000) \
+    X(0x2b, /* + */ \
+      0b00000, \
+      0b00100, \
+      0b00100, \
+      0b11111, \
+      0b00100, \
+      0b00100, \
+      0b00000, \
+      0b00000) \
+    X(0x2c, /* , */ \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b01100, \
+      0b00100, \
+      0b01000, \
+      0b00000) \
+    X(0x2d, /* - */ \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b11111, \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b00000) \
+    X(0x2e, /* . */ \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b01100, \
+      0b01100, \
+      0b00000) \
+    X(0x2f, /* / */ \
+      0b00000, \
+      0b00001, \
+      0b00010, \
+      0b00100, \
+      0b01000, \
+      0b10000, \
+      0b00000, \
+      0b00000) \
+    X(0x3a, /* : */ \
+      0b00000, \
+      0b01100, \
+      0b01100, \
+      0b00000, \
+      0b01100, \
+      0b01100, \
+      0b00000, \
+      0b00000) \
+    X(0x3b, /* ; */ \
+      0b00000, \
+      0b01100, \
+      0b01100, \
+      0b00000, \
+      0b01100, \
+      0b00100, \
+      0b01000, \
+      0b00000) \
+    X(0x3c, /* < */ \
+      0b00010, \
+      0b00100, \
+      0b01000, \
+      0b10000, \
+      0b01000, \
+      0b00100, \
+      0b00010, \
+      0b00000) \
+    X(0x3d, /* = */ \
+      0b00000, \
+      0b00000, \
+      0b11111, \
+      0b00000, \
+      0b11111, \
+      0b00000, \
+      0b00000, \
+      0b00000) \
+    X(0x3e, /* > */ \
+      0b01000, \
+      0b00100, \
+      0b00010, \
+      0b00001, \
+      0b00010, \
+      0b00100, \
+      0b01000, \
+      0b00000) \
+    X(0x3f, /* ? */ \
+      0b01110, \
+      0b10001, \
+      0b00001, \
+      0b00010, \
+      0b00100, \
+      0b00000, \
+      0b00100, \
+      0b00000) \
+    X(0x40, /* @ */ \
+      0b01110, \
+      0b10001, \
+      0b00001, \
+      0b01101, \
+      0b10101, \
+      0b10101, \
+      0b01110, \
+      0b00000) \
+    X(0x5b, /* [ */ \
+      0b01110, \
+      0b01000, \
+      0b01000, \
+      0b01000, \
+      0b01000, \
+      0b01000, \
+      0b01110, \
+      0b00000) \
+    X(0x5c, /* \ */ \
+      0b00000, \
+      0b10000, \
+      0b01000, \
+      0b00100, \
+      0b00010, \
+      0b00001, \
+      0b00000, \
+      0b00000) \
+    X(0x5d, /* ] */ \
+      0b01110, \
+      0b00010, \
+      0b00010, \
+      0b00010, \
+      0b00010, \
+      0b00010, \
+      0b01110, \
+      0b00000) \
+    X(0x5e, /* ^ */ \
+      0b00100, \
+      0b01010, \
+      0b10001, \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b00000) \
+    X(0x5f, /* _ */ \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b11111, \
+      0b00000) \
+    X(0x60, /* ` */ \
+      0b01000, \
+      0b00100, \
+      0b00010, \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b00000) \
+    X(0x7b, /* { */ \
+      0b00010, \
+      0b00100, \
+      0b00100, \
+      0b01000, \
+      0b00100, \
+      0b00100, \
+      0b00010, \
+      0b00000) \
+    X(0x7c, /* | */ \
+      0b00100, \
+      0b00100, \
+      0b00100, \
+      0b00100, \
+      0b00100, \
+      0b00100, \
+      0b00100, \
+      0b00000) \
+    X(0x7d, /* } */ \
+      0b01000, \
+      0b00100, \
+      0b00100, \
+      0b00010, \
+      0b00100, \
+      0b00100, \
+      0b01000, \
+      0b00000) \
+    X(0x7e, /* ~ */ \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b01101, \
+      0b10010, \
+      0b00000, \
+      0b00000, \
+      0b00000) \
+    X(0x7f, /* DEL */ \
+      0b00110, \
+      0b01001, \
+      0b01001, \
+      0b00110, \
+      0b00000, \
+      0b00000, \
+      0b00000, \
+      0b00000)
+
+
+// digits
+#define FONT_DIGITS(X) \
+    X(0x30, /* 0 */ \
+      0b01110, \
+      0b10001, \
+      0b10011, \
+      0b10101, \
+      0b11001, \
+      0b10001, \
+      0b01110, \
+      0b00000) \
+    X(0x31, /* 1 */ \
+      0b00100, \
+      0b01100, \
+      0b00100, \
+      0b00100, \
+      0b00100, \
+      0b00100, \
+      0b01110, \
+      0b00000) \
+    X(0x32, /* 2 */ \
+      0b01110, \
+      0b10001, \
+      0b00001, \
+      0b00010, \
+      0b00100, \
+      0b01000, \
+      0b11111, \
+      0b00000) \
+    X(0x33, /* 3 */ \
+      0b11111, \
+      0b00010, \
+      0b00100, \
+      0b00010, \
+      0b00001, \
+      0b10001, \
+      0b01110, \
+      0b00000) \
+    X(0x34, /* 4 */ \
+      0b00010, \
+      0b00110, \
+      0b01010, \
+      0b10010, \
+      0b11111, \
+      0b00010, \
+      0b00010, \
+      0b00000) \
+    X(0x35, /* 5 */ \
+      0b11111, \
+      0b10000, \
+      0b11110, \
+      0b00001, \
+      0b00001, \
+      0b10001, \
+      0b01110, \
+      0b00000) \
+    X(0x36, /* 6 */ \
+      0b00110, \
+      0b01000, \
+      0b10000, \
+      0b11110, \
+      0b10001, \
+      0b10001, \
+      0b01110, \
+      0b00000) \
+    X(0x37, /* 7 */ \
+      0b11111, \
+      0b00001, \
+      0b00010, \
+      0b00100, \
+      0b01000, \
+      0b01000, \
+      0b01000, \
+      0b00000) \
+    X(0x38, /* 8 */ \
+      0b01110, \
+      0b10001, \
+      0b10001, \
+      0b01110, \
+      0b10001, \
+      0b10001, \
+      0b01110, \
+      0b00000) \
+    X(0x39, /* 9 */ \
+      0b01110, \
+      0b10001, \
+      0b10001, \
+      0b01111, \
+      0b00001, \
+      0b00010, \
+      0b01100, \
+      0b00000)
+
+
+// upper case letters
+#define FONT_UPPER(X) \
+    X(0x41, /* A */ \
+      0b01110, \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b11111, \
+      0b10001, \
+      0b10001, \
+      0b00000) \
+    X(0x42, /* B */ \
+      0b11110, \
+      0b10001, \
+      0b10001, \
+      0b11110, \
+      0b10001, \
+      0b10001, \
+      0b11110, \
+      0b00000) \
+    X(0x43, /* C */ \
+      0b01110, \
+      0b10001, \
+      0b10000, \
+      0b10000, \
+      0b10000, \
+      0b10001, \
+      0b01110, \
+      0b00000) \
+    X(0x44, /* D */ \
+      0b11100, \
+      0b10010, \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b10010, \
+      0b11100, \
+      0b00000) \
+    X(0x45, /* E */ \
+      0b11111, \
+      0b10000, \
+      0b10000, \
+      0b11110, \
+      0b10000, \
+      0b10000, \
+      0b11111, \
+      0b00000) \
+    X(0x46, /* F */ \
+      0b11111, \
+      0b10000, \
+      0b10000, \
+      0b11110, \
+      0b10000, \
+      0b10000, \
+      0b10000, \
+      0b00000) \
+    X(0x47, /* G */ \
+      0b01110, \
+      0b10001, \
+      0b10000, \
+      0b10111, \
+      0b10001, \
+      0b10001, \
+      0b01111, \
+      0b00000) \
+    X(0x48, /* H */ \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b11111, \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b00000) \
+    X(0x49, /* I */ \
+      0b01110, \
+      0b00100, \
+      0b00100, \
+      0b00100, \
+      0b00100, \
+      0b00100, \
+      0b01110, \
+      0b00000) \
+    X(0x4a, /* J */ \
+      0b00111, \
+      0b00010, \
+      0b00010, \
+      0b00010, \
+      0b00010, \
+      0b10010, \
+      0b01100, \
+      0b00000) \
+    X(0x4b, /* K */ \
+      0b10001, \
+      0b10010, \
+      0b10100, \
+      0b11000, \
+      0b10100, \
+      0b10010, \
+      0b10001, \
+      0b00000) \
+    X(0x4c, /* L */ \
+      0b10000, \
+      0b10000, \
+      0b10000, \
+      0b10000, \
+      0b10000, \
+      0b10000, \
+      0b11111, \
+      0b00000) \
+    X(0x4d, /* M */ \
+      0b10001, \
+      0b11011, \
+      0b10101, \
+      0b10101, \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b00000) \
+    X(0x4e, /* N */ \
+      0b10001, \
+      0b10001, \
+      0b11001, \
+      0b10101, \
+      0b10011, \
+      0b10001, \
+      0b10001, \
+      0b00000) \
+    X(0x4f, /* O */ \
+      0b01110, \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b01110, \
+      0b00000) \
+    X(0x50, /* P */ \
+      0b11110, \
+      0b10001, \
+      0b10001, \
+      0b11110, \
+      0b10000, \
+      0b10000, \
+      0b10000, \
+      0b00000) \
+    X(0x51, /* Q */ \
+      0b01110, \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b10101, \
+      0b10010, \
+      0b01101, \
+      0b00000) \
+    X(0x52, /* R */ \
+      0b11110, \
+      0b10001, \
+      0b10001, \
+      0b11110, \
+      0b10100, \
+      0b10010, \
+      0b10001, \
+      0b00000) \
+    X(0x53, /* S */ \
+      0b01111, \
+      0b10000, \
+      0b10000, \
+      0b01110, \
+      0b00001, \
+      0b00001, \
+      0b11110, \
+      0b00000) \
+    X(0x54, /* T */ \
+      0b11111, \
+      0b00100, \
+      0b00100, \
+      0b00100, \
+      0b00100, \
+      0b00100, \
+      0b00100, \
+      0b00000) \
+    X(0x55, /* U */ \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b01110, \
+      0b00000) \
+    X(0x56, /* V */ \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b01010, \
+      0b00100, \
+      0b00000) \
+    X(0x57, /* W */ \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b10101, \
+      0b10101, \
+      0b10101, \
+      0b01010, \
+      0b00000) \
+    X(0x58, /* X */ \
+      0b10001, \
+      0b10001, \
+      0b01010, \
+      0b00100, \
+      0b01010, \
+      0b10001, \
+      0b10001, \
+      0b00000) \
+    X(0x59, /* Y */ \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b01010, \
+      0b00100, \
+      0b00100, \
+      0b00100, \
+      0b00000) \
+    X(0x5a, /* Z */ \
+      0b11111, \
+      0b00001, \
+      0b00010, \
+      0b00100, \
+      0b01000, \
+      0b10000, \
+      0b11111, \
+      0b00000)
+
+
+// lower case letters
+#define FONT_LOWER(X) \
+    X(0x61, /* a */ \
+      0b00000, \
+      0b00000, \
+      0b01110, \
+      0b00001, \
+      0b01111, \
+      0b10001, \
+      0b01111, \
+      0b00000) \
+    X(0x62, /* b */ \
+      0b10000, \
+      0b10000, \
+      0b10110, \
+      0b11001, \
+      0b10001, \
+      0b10001, \
+      0b11110, \
+      0b00000) \
+    X(0x63, /* c */ \
+      0b00000, \
+      0b00000, \
+      0b01110, \
+      0b10000, \
+      0b10000, \
+      0b10001, \
+      0b01110, \
+      0b00000) \
+    X(0x64, /* d */ \
+      0b00001, \
+      0b00001, \
+      0b01101, \
+      0b10011, \
+      0b10001, \
+      0b10001, \
+      0b01111, \
+      0b00000) \
+    X(0x65, /* e */ \
+      0b00000, \
+      0b00000, \
+      0b01110, \
+      0b10001, \
+      0b11111, \
+      0b10000, \
+      0b01110, \
+      0b00000) \
+    X(0x66, /* f */ \
+      0b00110, \
+      0b01001, \
+      0b01000, \
+      0b11100, \
+      0b01000, \
+      0b01000, \
+      0b01000, \
+      0b00000) \
+    X(0x67, /* g */ \
+      0b00000, \
+      0b01111, \
+      0b10001, \
+      0b10001, \
+      0b01111, \
+      0b00001, \
+      0b01110, \
+      0b00000) \
+    X(0x68, /* h */ \
+      0b10000, \
+      0b10000, \
+      0b10110, \
+      0b11001, \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b00000) \
+    X(0x69, /* i */ \
+      0b00100, \
+      0b00000, \
+      0b01100, \
+      0b00100, \
+      0b00100, \
+      0b00100, \
+      0b01110, \
+      0b00000) \
+    X(0x6a, /* j */ \
+      0b00010, \
+      0b00000, \
+      0b00110, \
+      0b00010, \
+      0b00010, \
+      0b10010, \
+      0b01100, \
+      0b00000) \
+    X(0x6b, /* k */ \
+      0b10000, \
+      0b10000, \
+      0b10010, \
+      0b10100, \
+      0b11000, \
+      0b10100, \
+      0b10010, \
+      0b00000) \
+    X(0x6c, /* l */ \
+      0b01100, \
+      0b00100, \
+      0b00100, \
+      0b00100, \
+      0b00100, \
+      0b00100, \
+      0b01110, \
+      0b00000) \
+    X(0x6d, /* m */ \
+      0b00000, \
+      0b00000, \
+      0b11010, \
+      0b10101, \
+      0b10101, \
+      0b10001, \
+      0b10001, \
+      0b00000) \
+    X(0x6e, /* n */ \
+      0b00000, \
+      0b00000, \
+      0b10110, \
+      0b11001, \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b00000) \
+    X(0x6f, /* o */ \
+      0b00000, \
+      0b00000, \
+      0b01110, \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b01110, \
+      0b00000) \
+    X(0x70, /* p */ \
+      0b00000, \
+      0b00000, \
+      0b11110, \
+      0b10001, \
+      0b11110, \
+      0b10000, \
+      0b10000, \
+      0b00000) \
+    X(0x71, /* q */ \
+      0b00000, \
+      0b00000, \
+      0b01101, \
+      0b10011, \
+      0b01111, \
+      0b00001, \
+      0b00001, \
+      0b00000) \
+    X(0x72, /* r */ \
+      0b00000, \
+      0b00000, \
+      0b10110, \
+      0b11001, \
+      0b10000, \
+      0b10000, \
+      0b10000, \
+      0b00000) \
+    X(0x73, /* s */ \
+      0b00000, \
+      0b00000, \
+      0b01110, \
+      0b10000, \
+      0b01110, \
+      0b00001, \
+      0b11110, \
+      0b00000) \
+    X(0x74, /* t */ \
+      0b01000, \
+      0b01000, \
+      0b11100, \
+      0b01000, \
+      0b01000, \
+      0b01001, \
+      0b00110, \
+      0b00000) \
+    X(0x75, /* u */ \
+      0b00000, \
+      0b00000, \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b10011, \
+      0b01101, \
+      0b00000) \
+    X(0x76, /* v */ \
+      0b00000, \
+      0b00000, \
+      0b10001, \
+      0b10001, \
+      0b10001, \
+      0b01010, \
+      0b00100, \
+      0b00000) \
+    X(0x77, /* w */ \
+      0b00000, \
+      0b00000, \
+      0b10001, \
+      0b10001, \
+      0b10101, \
+      0b10101, \
+      0b01010, \
+      0b00000) \
+    X(0x78, /* x */ \
+      0b00000, \
+      0b00000, \
+      0b10001, \
+      0b01010, \
+      0b00100, \
+      0b01010, \
+      0b10001, \
+      0b00000) \
+    X(0x79, /* y */ \
+      0b00000, \
+      0b00000, \
+      0b10001, \
+      0b10001, \
+      0b01111, \
+      0b00001, \
+      0b01110, \
+      0b00000) \
+    X(0x7a, /* z */ \
+      0b00000, \
+      0b00000, \
+      0b11111, \
+      0b00010, \
+      0b00100, \
+      0b01000, \
+      0b11111, \
+      0b00000)
+
+// slot numbers, slot 0 is the fallback
+#define FONT_SLOT(code, ...) FONT_SLOT_##code,
+enum {
+    FONT_SLOT_FALLBACK,
+#if FONT_USE_PUNCT
+    FONT_PUNCT(FONT_SLOT)
+#endif
+#if FONT_USE_DIGITS
+    FONT_DIGITS(FONT_SLOT)
+#endif
+#if FONT_USE_UPPER
+    FONT_UPPER(FONT_SLOT)
+#endif
+#if FONT_USE_LOWER
+    FONT_LOWER(FONT_SLOT)
+#endif
+    FONT_SLOTS
+};
+
+// column bytes of every stored glyph
+#define FONT_DATA(code, ...) FONT_GLYPH(__VA_ARGS__),
+static const unsigned char FONT_GLYPHS[FONT_SLOTS][5] = {
+    FONT_GLYPH(FONT_FALLBACK),
+#if FONT_USE_PUNCT
+    FONT_PUNCT(FONT_DATA)
+#endif
+#if FONT_USE_DIGITS
+    FONT_DIGITS(FONT_DATA)
+#endif
+#if FONT_USE_UPPER
+    FONT_UPPER(FONT_DATA)
+#endif
+#if FONT_USE_LOWER
+    FONT_LOWER(FONT_DATA)
+#endif
+};
+
+// ascii code -> slot, everything not listed is 0 (the fallback)
+#define FONT_MAP(code, ...) [code] = FONT_SLOT_##code,
+static const unsigned char FONT_INDEX[128] = {
+#if FONT_USE_PUNCT
+    FONT_PUNCT(FONT_MAP)
+#endif
+#if FONT_USE_DIGITS
+    FONT_DIGITS(FONT_MAP)
+#endif
+#if FONT_USE_UPPER
+    FONT_UPPER(FONT_MAP)
+#endif
+#if FONT_USE_LOWER
+    FONT_LOWER(FONT_MAP)
+#endif
+};
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef CHECK_H__
+#define CHECK_H__
+
+// failure counting for the host tests, every test is a main() that returns 1 if anything failed
+
+#include <stdio.h>
+
+static int check_failures = 0;
+
+// prints the first few failures, counts all of them
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        if (check_failures++ < 10) { \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } \
+} while (0)
+
+static int check_done(const char * name) {
+    printf("%s: %s (%d failures)\n", name, check_failures ? "FAILED" : "ok", check_failures);
+    return check_failures != 0;
+}
+
+#endif
@@ -0,0 +1,288 @@
+// register simulation for the host tests, see sim.h
+
+#define SIM_DEFINE
+#include "xc.h"
+#include <string.h>
+
+#define SIM_MAX_PA 64
+
+simEdge sim_edges[SIM_MAX_EDGES];
+int sim_num_edges = 0;
+unsigned long long sim_ticks = 0;
+void (*sim_dma1_isr)(void) = 0;
+int (*sim_adc)(int pin) = 0;
+
+static const volatile void * sim_pa_table[SIM_MAX_PA]; // handle - 1 -> pointer
+static int sim_num_pa = 0;
+
+// a write to a SET/CLR/INV register lands at the next access
+static volatile unsigned int * sim_op_reg = 0;
+static int sim_op_kind;
+static volatile unsigned int sim_op_value;
+
+static unsigned int sim_tmr2_value = 0; // what the last TMR2 access saw, to spot writes
+static volatile unsigned int sim_tmr2_reg = 0;
+static unsigned long long sim_tmr2_base = 0; // sim_ticks when TMR2 was 0, while it runs
+static unsigned int sim_t2_on = 0;
+static unsigned int sim_last_pins = 0;
+
+static unsigned int sim_oc_on = 0;
+static unsigned int sim_oc_out = 0; // OC4 output
+static unsigned long long sim_oc_match = 0; // sim_ticks + 1 of the last match, 0 for none
+static unsigned int sim_dma1_on = 0;
+static unsigned int sim_dma1_ptr = 0; // source bytes done
+static unsigned long long sim_dma1_at = 0; // when the pending transfer happens, 0 for none
+static int sim_in_isr = 0;
+
+void sim_reset() {
+    // every register is a volatile union of sim_*, they are all zeroed by name here
+#define SIM_ZERO(name) sim_##name.w = 0;
+    SIM_ZERO(T2CON) SIM_ZERO(PR2) SIM_ZERO(TRISB) SIM_ZERO(ANSELB) SIM_ZERO(LATB) SIM_ZERO(PORTB)
+    SIM_ZERO(RPB6R) SIM_ZERO(SPI1CON) SIM_ZERO(SPI1STAT) SIM_ZERO(SPI1BUF) SIM_ZERO(SPI1BRG)
+    SIM_ZERO(DMACON) SIM_ZERO(OC4CON) SIM_ZERO(OC4R) SIM_ZERO(IFS0) SIM_ZERO(IEC0)
+    SIM_ZERO(DCH0CON) SIM_ZERO(DCH0ECON) SIM_ZERO(DCH0INT) SIM_ZERO(DCH0SSA) SIM_ZERO(DCH0DSA)
+    SIM_ZERO(DCH0SSIZ) SIM_ZERO(DCH0DSIZ) SIM_ZERO(DCH0CSIZ)
+    SIM_ZERO(DCH1CON) SIM_ZERO(DCH1ECON) SIM_ZERO(DCH1INT) SIM_ZERO(DCH1SSA) SIM_ZERO(DCH1DSA)
+    SIM_ZERO(DCH1SSIZ) SIM_ZERO(DCH1DSIZ) SIM_ZERO(DCH1CSIZ) SIM_ZERO(IFS1) SIM_ZERO(IEC1) SIM_ZERO(IPC10)
+    SIM_ZERO(DCH2CON) SIM_ZERO(DCH2ECON) SIM_ZERO(DCH2INT) SIM_ZERO(DCH2SSA) SIM_ZERO(DCH2DSA)
+    SIM_ZERO(DCH2SSIZ) SIM_ZERO(DCH2DSIZ) SIM_ZERO(DCH2CSIZ)
+    SIM_ZERO(T3CON) SIM_ZERO(PR3) SIM_ZERO(TMR3) SIM_ZERO(T4CON) SIM_ZERO(PR4) SIM_ZERO(TMR4)
+    SIM_ZERO(TRISA) SIM_ZERO(LATA) SIM_ZERO(AD1CON1) SIM_ZERO(AD1CON2) SIM_ZERO(AD1CON3) SIM_ZERO(AD1CHS)
+    SIM_ZERO(AD1CSSL) SIM_ZERO(CTMUCON) SIM_ZERO(IPC4) SIM_ZERO(IPC5) SIM_ZERO(INTCON) SIM_ZERO(BMXCON)
+    SIM_ZERO(DDPCON)
+#undef SIM_ZERO
+    memset((void *) sim_ADC1BUF, 0, sizeof(sim_ADC1BUF));
+    sim_SPI1STAT.bits.SRMT = 1; // nothing being shifted out
+    sim_op_reg = 0;
+    sim_tmr2_value = 0;
+    sim_tmr2_reg = 0;
+    sim_tmr2_base = 0;
+    sim_t2_on = 0;
+    sim_last_pins = 0;
+    sim_oc_on = 0;
+    sim_oc_out = 0;
+    sim_oc_match = 0;
+    sim_dma1_on = 0;
+    sim_dma1_ptr = 0;
+    sim_dma1_at = 0;
+    sim_in_isr = 0;
+    sim_ticks = 0;
+    sim_num_edges = 0;
+}
+
+// OC4 drives B6 while it is mapped there and on, otherwise LATB does
+unsigned int sim_pins() {
+    unsigned int pins = sim_LATB.w & 0xFFFF;
+    if (sim_RPB6R.bits.RPB6R == 0b0101 && sim_OC4CON.bits.ON) {
+        pins = (pins & ~(1u << 6)) | (sim_oc_out << 6);
+    }
+    return pins;
+}
+
+static unsigned int sim_tmr2_now() {
+    if (!sim_t2_on) {
+        return sim_tmr2_reg & 0xFFFF;
+    }
+    return (unsigned int) (sim_ticks - sim_tmr2_base) & 0xFFFF;
+}
+
+static void sim_record() {
+    unsigned int pins = sim_pins();
+    if (pins != sim_last_pins && sim_num_edges < SIM_MAX_EDGES) {
+        sim_edges[sim_num_edges].t = sim_ticks;
+        sim_edges[sim_num_edges].pins = pins;
+        sim_edges[sim_num_edges].iec0 = sim_IEC0.w;
+        sim_num_edges++;
+    }
+    sim_last_pins = pins;
+}
+
+// an auto sample burst of SMPI + 1 conversions into ADC1BUF0 on, done by the next access
+static void sim_adc_run() {
+    int i;
+    if (!sim_AD1CON1.bits.ON || !sim_AD1CON1.bits.ASAM || sim_AD1CON1.bits.SSRC != 0b111 || !sim_adc) {
+        return;
+    }
+    for (i = 0; i <= sim_AD1CON2.bits.SMPI; i++) {
+        sim_ADC1BUF[i * 4] = sim_adc(sim_AD1CHS.bits.CH0SA) & 0x3FF;
+    }
+    sim_AD1CON1.bits.DONE = 1;
+    sim_IFS0.bits.AD1IF = 1;
+    if (sim_AD1CON1.bits.CLRASAM) {
+        sim_AD1CON1.bits.ASAM = 0; // stops after the burst
+    }
+}
+
+void sim_sync() {
+    if (sim_op_reg) {
+        if (sim_op_kind == SIM_SET) {
+            *sim_op_reg |= sim_op_value;
+        } else if (sim_op_kind == SIM_CLR) {
+            *sim_op_reg &= ~sim_op_value;
+        } else {
+            *sim_op_reg ^= sim_op_value;
+        }
+        sim_op_reg = 0;
+    }
+    // TMR2 written since the last access, or Timer2 turned on or off
+    if (sim_tmr2_reg != sim_tmr2_value) {
+        sim_tmr2_base = sim_ticks - (sim_tmr2_reg & 0xFFFF);
+    }
+    if (sim_T2CON.bits.ON != sim_t2_on) {
+        if (sim_t2_on) {
+            sim_tmr2_reg = sim_tmr2_now(); // stops where it is
+        } else {
+            sim_tmr2_base = sim_ticks - (sim_tmr2_reg & 0xFFFF);
+        }
+        sim_t2_on = sim_T2CON.bits.ON;
+    }
+    sim_tmr2_value = sim_tmr2_reg = sim_tmr2_now();
+
+    // toggle mode starts low, the DMA starts at the beginning of the source
+    if (sim_OC4CON.bits.ON != sim_oc_on) {
+        sim_oc_on = sim_OC4CON.bits.ON;
+        sim_oc_out = 0;
+        sim_oc_match = 0;
+    }
+    if (sim_DCH1CON.bits.CHEN != sim_dma1_on) {
+        sim_dma1_on = sim_DCH1CON.bits.CHEN;
+        sim_dma1_ptr = 0;
+        sim_dma1_at = 0;
+    }
+    sim_adc_run();
+    sim_record();
+}
+
+// DMA channel 1 moves one cell (DCH1CSIZ bytes, 2 here) from the source to OC4R
+static void sim_dma1_transfer() {
+    volatile unsigned char * src = sim_va(sim_DCH1SSA.w);
+    if (!sim_DCH1CON.bits.CHEN || !src) {
+        return;
+    }
+    sim_OC4R.w = src[sim_dma1_ptr] | (src[sim_dma1_ptr + 1] << 8);
+    sim_dma1_ptr += 2;
+    if (sim_dma1_ptr >= sim_DCH1SSIZ.w) {
+        sim_DCH1CON.bits.CHEN = 0;
+        sim_dma1_on = 0;
+        sim_dma1_ptr = 0;
+        sim_DCH1INT.bits.CHBCIF = 1;
+        if (sim_DCH1INT.bits.CHBCIE) {
+            sim_IFS1.bits.DMA1IF = 1;
+        }
+    }
+}
+
+// run OC4 and DMA channel 1 up to end, taking every compare match and transfer in order
+static void sim_run(unsigned long long end) {
+    unsigned long long match, next;
+    unsigned int d;
+
+    while (1) {
+        match = end;
+        if (sim_t2_on && sim_oc_on && sim_OC4CON.bits.OCM == 0b011) {
+            d = (sim_OC4R.w - sim_tmr2_now()) & 0xFFFF; // PR2 is 65535
+            if (d == 0 && sim_oc_match == sim_ticks + 1) {
+                d = 65536; // already matched this tick
+            }
+            match = sim_ticks + d;
+        }
+        next = match;
+        if (sim_dma1_at && sim_dma1_at < next) {
+            next = sim_dma1_at;
+        }
+        if (next >= end) {
+            break;
+        }
+        sim_ticks = next;
+        if (sim_dma1_at == next) {
+            sim_dma1_at = 0;
+            sim_dma1_transfer();
+        } else {
+            sim_oc_out = !sim_oc_out;
+            sim_oc_match = sim_ticks + 1;
+            sim_IFS0.bits.OC4IF = 1;
+            sim_record();
+            if (sim_DCH1CON.bits.CHEN && sim_DCH1ECON.bits.SIRQEN && sim_DCH1ECON.bits.CHSIRQ == _OUTPUT_COMPARE_4_IRQ
+                    && !sim_dma1_at) {
+                sim_dma1_at = sim_ticks + SIM_DMA_TICKS;
+            }
+        }
+    }
+    sim_ticks = end;
+}
+
+// time passes for the CPU, then any interrupt that came up runs
+static void sim_step(unsigned int ticks) {
+    sim_run(sim_ticks + ticks);
+    if (!sim_in_isr && sim_IFS1.bits.DMA1IF && sim_IEC1.bits.DMA1IE && sim_dma1_isr) {
+        sim_in_isr = 1;
+        sim_dma1_isr();
+        sim_sync();
+        sim_in_isr = 0;
+    }
+}
+
+void sim_wait(unsigned int ticks) {
+    sim_sync();
+    while (ticks >= SIM_READ_TICKS) {
+        sim_step(SIM_READ_TICKS);
+        ticks -= SIM_READ_TICKS;
+    }
+}
+
+unsigned int sim_pa(const volatile void * p) {
+    int i;
+    for (i = 0; i < sim_num_pa; i++) {
+        if (sim_pa_table[i] == p) {
+            return i + 1;
+        }
+    }
+    if (sim_num_pa == SIM_MAX_PA) {
+        return 0;
+    }
+    sim_pa_table[sim_num_pa++] = p;
+    return sim_num_pa;
+}
+
+volatile void * sim_va(unsigned int pa) {
+    if (pa == 0 || pa > (unsigned int) sim_num_pa) {
+        return 0;
+    }
+    return (volatile void *) sim_pa_table[pa - 1];
+}
+
+volatile unsigned int * sim_op(volatile unsigned int * reg, int op) {
+    sim_sync();
+    sim_op_reg = reg;
+    sim_op_kind = op;
+    sim_op_value = 0;
+    return &sim_op_value;
+}
+
+volatile unsigned int * sim_tmr2() {
+    sim_sync();
+    sim_step(SIM_READ_TICKS);
+    return &sim_tmr2_reg; // the value when the read started
+}
+
+volatile void * sim_latb() {
+    sim_sync();
+    return &sim_LATB;
+}
+
+volatile void * sim_portb() {
+    sim_sync();
+    sim_PORTB.w = sim_pins();
+    return &sim_PORTB;
+}
+
+volatile void * sim_ifs0() {
+    sim_sync();
+    return &sim_IFS0;
+}
+
+unsigned int sim_cp0() {
+    sim_sync();
+    sim_step(SIM_READ_TICKS);
+    return (unsigned int) (sim_ticks / 2); // the core timer is half the 48MHz clock
+}
@@ -0,0 +1,50 @@
+#ifndef SIM_H__
+#define SIM_H__
+
+// Host simulation of the PIC32 registers the HW7 drivers use, for the tests in this folder.
+// Time is counted in 48MHz ticks. Only the registers that are polled take time: every read
+// of TMR2 or the core timer is SIM_READ_TICKS, so a polling loop moves the clock along about
+// like it does on the chip, and the code in between is free.
+// Writes to LATB are recorded as edges of the B pins, stamped with the time of the next
+// simulated access (the time the write lands, give or take one read).
+// OC4 in toggle mode on B6 and DMA channel 1 loading OC4R on its match are simulated too, with
+// the block done interrupt calling sim_dma1_isr. The ADC does auto sample bursts (ASAM with
+// SSRC = 0b111) of the codes sim_adc gives, the rest of the peripherals are just registers.
+
+#define SIM_READ_TICKS 4 // 48MHz ticks per polled read, lw + compare + branch
+#define SIM_DMA_TICKS 6 // from the OC4 match to OC4R holding the next time
+#define SIM_MAX_EDGES 200000
+
+typedef struct {
+    unsigned long long t; // 48MHz ticks
+    unsigned int pins; // B pins after the change
+    unsigned int iec0; // IEC0 when it changed, which interrupts could have stretched it
+} simEdge;
+
+extern simEdge sim_edges[SIM_MAX_EDGES];
+extern int sim_num_edges;
+extern unsigned long long sim_ticks;
+extern void (*sim_dma1_isr)(void);
+extern int (*sim_adc)(int pin); // 10 bit code of an AN pin, for every conversion
+
+void sim_reset(void); // registers to 0, time to 0, no edges
+void sim_sync(void); // land any pending write, call it before looking at the edges
+void sim_wait(unsigned int ticks); // let the peripherals run, like a busy loop of the CPU
+unsigned int sim_pins(void); // B pins as they are now
+
+// physical address handles for KVA_TO_PA, and the pointer behind one
+unsigned int sim_pa(const volatile void * p);
+volatile void * sim_va(unsigned int pa);
+
+// hooks behind the register macros of xc.h
+#define SIM_SET 0
+#define SIM_CLR 1
+#define SIM_INV 2
+volatile unsigned int * sim_op(volatile unsigned int * reg, int op);
+volatile unsigned int * sim_tmr2(void);
+volatile void * sim_latb(void);
+volatile void * sim_portb(void);
+volatile void * sim_ifs0(void);
+unsigned int sim_cp0(void);
+
+#endif
@@ -0,0 +1,2 @@
+// host stand-in for the XC32 header, an ISR is just a function the simulation calls
+#define __ISR(vector, ipl)
@@ -0,0 +1,4 @@
+// host stand-in for the XC32 header, physical addresses are handles from the simulation
+#include "sim.h"
+#define KVA_TO_PA(v) sim_pa((const volatile void *) (v))
+#define KVA0_TO_KVA1(v) (v)
@@ -0,0 +1,323 @@
+// dsp.c against the same filters in double precision, on full scale random samples and on a
+// step. The references use the rounded coefficients dsp.c gets, so only the fixed point
+// arithmetic is being checked, not the coefficient rounding of the design:
+//  - FIR (Q15 and Q31): one rounding at the end, the shift truncates, so the result is the
+//    floor of the reference, within 1 LSB below it.
+//  - biquad cascade: every section truncates its output, less than 1 LSB, and that error goes
+//    round the section's feedback (1/A) and through the sections after it. The limit is the sum
+//    of the L1 norms of those paths, worked out here in double, the most it can add up to.
+//  - moving average: exactly the floor of the mean of the last 2^shift samples.
+//  - running median: exactly the middle of the sorted window.
+// The _block functions have to give the same output as one sample at a time, also when the
+// samples come in blocks of uneven sizes.
+
+#include "check.h"
+#include <math.h>
+#include <stdlib.h>
+#include "dsp.h"
+
+#define N 4000 // samples per run
+#define STEP_AT 100 // sample the step goes up at
+#define FIR_TAPS 31
+#define SECTIONS 2
+#define AVG_SHIFT 4
+#define MEDIAN_LEN 9
+
+#define INPUTS 2
+static const char * input_names[INPUTS] = {"random", "step"};
+
+static short in16[N], out16[N], blk16[N];
+static int in32[N], out32[N], blk32[N];
+static double ref[N];
+
+static short fir_h[FIR_TAPS];
+static int fir32_h[FIR_TAPS];
+static dspBiquadCoeffs bq[SECTIONS];
+
+static void make_input(int input, int amplitude) {
+    int i;
+    for (i = 0; i < N; i++) {
+        if (input == 0) {
+            in16[i] = rand() % (2 * amplitude + 1) - amplitude;
+        } else {
+            in16[i] = i < STEP_AT ? 0 : amplitude;
+        }
+    }
+}
+
+// random Q31 ints of about +-2^30, or a step of 2^30
+static void make_input32(int input) {
+    int i;
+    for (i = 0; i < N; i++) {
+        if (input == 0) {
+            in32[i] = (int) (((long long) rand() << 16 ^ rand()) % (1 << 30)) * (rand() & 1 ? 1 : -1);
+        } else {
+            in32[i] = i < STEP_AT ? 0 : 1 << 30;
+        }
+    }
+}
+
+// blocks of 1 to 37 samples, so the state has to carry over between calls of every size
+static int next_block(int i) {
+    int n = 1 + (i * 7) % 37;
+    return i + n > N ? N - i : n;
+}
+
+// windowed sinc low pass, cutoff 0.1 of the sample rate
+static double fir_design(int k) {
+    double m = k - (FIR_TAPS - 1) / 2.0;
+    double sinc = m == 0 ? 2 * 0.1 : sin(2 * M_PI * 0.1 * m) / (M_PI * m);
+    return sinc * (0.54 - 0.46 * cos(2 * M_PI * k / (FIR_TAPS - 1)));
+}
+
+// worst of ref - out, which has to be 0 to just under 1
+static double floor_error(const char * name, int input, const double * r, const int * got, const short * got16) {
+    double worst = 0, e;
+    int i;
+    for (i = 0; i < N; i++) {
+        e = r[i] - (got ? got[i] : got16[i]);
+        if (fabs(e) > fabs(worst)) {
+            worst = e;
+        }
+        CHECK(e >= 0 && e < 1, "%s, %s input: sample %d is %d, reference %.3f", name, input_names[input],
+                i, got ? got[i] : got16[i], r[i]);
+    }
+    return worst;
+}
+
+static void check_fir(int input) {
+    static short state[2 * FIR_TAPS];
+    dspFir f;
+    int i, k, n;
+
+    make_input(input, 16000);
+    dsp_fir_init(&f, fir_h, state, FIR_TAPS);
+    for (i = 0; i < N; i++) {
+        out16[i] = dsp_fir(&f, in16[i]);
+        ref[i] = 0;
+        for (k = 0; k < FIR_TAPS && k <= i; k++) {
+            ref[i] += fir_h[k] / 32768.0 * in16[i - k];
+        }
+        CHECK(fabs(ref[i]) < 32767, "FIR, %s input: the reference saturates at %d", input_names[input], i);
+    }
+    printf("FIR Q15    %-6s: worst %.3f LSB", input_names[input], floor_error("FIR", input, ref, 0, out16));
+
+    dsp_fir_init(&f, fir_h, state, FIR_TAPS);
+    for (i = 0; i < N; i += n) {
+        n = next_block(i);
+        dsp_fir_block(&f, in16 + i, blk16 + i, n);
+    }
+    for (i = 0; i < N; i++) {
+        CHECK(blk16[i] == out16[i], "FIR block, %s input: sample %d is %d, one at a time %d",
+                input_names[input], i, blk16[i], out16[i]);
+    }
+    printf(", block the same\n");
+}
+
+static void check_fir32(int input) {
+    static int state[2 * FIR_TAPS];
+    dspFir32 f;
+    int i, k, n;
+
+    make_input32(input);
+    dsp_fir32_init(&f, fir32_h, state, FIR_TAPS);
+    for (i = 0; i < N; i++) {
+        out32[i] = dsp_fir32(&f, in32[i]);
+        ref[i] = 0;
+        for (k = 0; k < FIR_TAPS && k <= i; k++) {
+            ref[i] += fir32_h[k] / 2147483648.0 * in32[i - k];
+        }
+    }
+    printf("FIR Q31    %-6s: worst %.3f LSB", input_names[input], floor_error("FIR32", input, ref, out32, 0));
+
+    dsp_fir32_init(&f, fir32_h, state, FIR_TAPS);
+    for (i = 0; i < N; i += n) {
+        n = next_block(i);
+        dsp_fir32_block(&f, in32 + i, blk32 + i, n);
+    }
+    for (i = 0; i < N; i++) {
+        CHECK(blk32[i] == out32[i], "FIR32 block, %s input: sample %d is %d, one at a time %d",
+                input_names[input], i, blk32[i], out32[i]);
+    }
+    printf(", block the same\n");
+}
+
+// one section in double, s is x1 x2 y1 y2. feedback_only leaves out the b side, y = x - a1 y1 - a2 y2
+static double biquad_double(const dspBiquadCoeffs * c, double * s, double x, int feedback_only) {
+    double y;
+    if (feedback_only) {
+        y = x;
+    } else {
+        y = (c->b0 * x + c->b1 * s[0] + c->b2 * s[1]) / 16384.0;
+    }
+    y -= (c->a1 * s[2] + c->a2 * s[3]) / 16384.0;
+    s[1] = s[0];
+    s[0] = x;
+    s[3] = s[2];
+    s[2] = y;
+    return y;
+}
+
+// most the truncation of every section can move the output: the L1 norm of the impulse
+// response from the output of section k (its feedback, then the sections after it), summed
+static double biquad_bound() {
+    double s[SECTIONS][4];
+    double bound = 0, x;
+    int k, j, i;
+
+    for (k = 0; k < SECTIONS; k++) {
+        for (j = 0; j < SECTIONS; j++) {
+            s[j][0] = s[j][1] = s[j][2] = s[j][3] = 0;
+        }
+        for (i = 0; i < N; i++) {
+            x = biquad_double(&bq[k], s[k], i == 0, 1);
+            for (j = k + 1; j < SECTIONS; j++) {
+                x = biquad_double(&bq[j], s[j], x, 0);
+            }
+            bound += fabs(x);
+        }
+    }
+    return bound;
+}
+
+static void check_biquad(int input, double bound) {
+    static short state[4 * SECTIONS];
+    double s[SECTIONS][4];
+    dspBiquad f;
+    double x, e, worst = 0;
+    int i, j, n;
+
+    make_input(input, 12000);
+    dsp_biquad_init(&f, bq, state, SECTIONS);
+    for (j = 0; j < SECTIONS; j++) {
+        s[j][0] = s[j][1] = s[j][2] = s[j][3] = 0;
+    }
+    for (i = 0; i < N; i++) {
+        out16[i] = dsp_biquad(&f, in16[i]);
+        x = in16[i];
+        for (j = 0; j < SECTIONS; j++) {
+            x = biquad_double(&bq[j], s[j], x, 0);
+            CHECK(fabs(x) < 32767, "biquad, %s input: the reference saturates at %d", input_names[input], i);
+        }
+        e = x - out16[i];
+        if (fabs(e) > fabs(worst)) {
+            worst = e;
+        }
+        CHECK(fabs(e) <= bound, "biquad, %s input: sample %d is %d, reference %.3f", input_names[input], i, out16[i], x);
+    }
+    printf("biquad x%d %-6s: worst %.3f LSB of %.2f", SECTIONS, input_names[input], worst, bound);
+
+    dsp_biquad_init(&f, bq, state, SECTIONS);
+    for (i = 0; i < N; i += n) {
+        n = next_block(i);
+        dsp_biquad_block(&f, in16 + i, blk16 + i, n);
+    }
+    for (i = 0; i < N; i++) {
+        CHECK(blk16[i] == out16[i], "biquad block, %s input: sample %d is %d, one at a time %d",
+                input_names[input], i, blk16[i], out16[i]);
+    }
+    printf(", block the same\n");
+}
+
+static void check_average(int input) {
+    static short ring[1 << AVG_SHIFT];
+    dspAverage f;
+    int i, k, n;
+
+    make_input(input, 32767);
+    dsp_average_init(&f, ring, AVG_SHIFT);
+    for (i = 0; i < N; i++) {
+        out16[i] = dsp_average(&f, in16[i]);
+        ref[i] = 0;
+        for (k = 0; k < (1 << AVG_SHIFT) && k <= i; k++) {
+            ref[i] += in16[i - k];
+        }
+        ref[i] /= 1 << AVG_SHIFT;
+        CHECK(out16[i] == floor(ref[i]), "average, %s input: sample %d is %d, mean %.4f",
+                input_names[input], i, out16[i], ref[i]);
+    }
+    printf("average %2d %-6s: worst %.3f LSB", 1 << AVG_SHIFT, input_names[input],
+            floor_error("average", input, ref, 0, out16));
+
+    dsp_average_init(&f, ring, AVG_SHIFT);
+    for (i = 0; i < N; i += n) {
+        n = next_block(i);
+        dsp_average_block(&f, in16 + i, blk16 + i, n);
+    }
+    for (i = 0; i < N; i++) {
+        CHECK(blk16[i] == out16[i], "average block, %s input: sample %d is %d, one at a time %d",
+                input_names[input], i, blk16[i], out16[i]);
+    }
+    printf(", block the same\n");
+}
+
+static int compare_short(const void * a, const void * b) {
+    return *(const short *) a - *(const short *) b;
+}
+
+static void check_median(int input) {
+    dspMedian f;
+    short window[MEDIAN_LEN];
+    int i, k, n;
+
+    make_input(input, 32767);
+    if (input == 0) {
+        for (i = 0; i < N; i += 5) {
+            in16[i] = in16[i] / 64; // small values with spikes between them, and repeats
+        }
+    }
+    dsp_median_init(&f, MEDIAN_LEN);
+    for (i = 0; i < N; i++) {
+        out16[i] = dsp_median(&f, in16[i]);
+        for (k = 0; k < MEDIAN_LEN; k++) {
+            window[k] = i - k >= 0 ? in16[i - k] : 0;
+        }
+        qsort(window, MEDIAN_LEN, sizeof(short), compare_short);
+        CHECK(out16[i] == window[MEDIAN_LEN / 2], "median, %s input: sample %d is %d, not %d",
+                input_names[input], i, out16[i], window[MEDIAN_LEN / 2]);
+    }
+    printf("median %2d  %-6s: exact", MEDIAN_LEN, input_names[input]);
+
+    dsp_median_init(&f, MEDIAN_LEN);
+    for (i = 0; i < N; i += n) {
+        n = next_block(i);
+        dsp_median_block(&f, in16 + i, blk16 + i, n);
+    }
+    for (i = 0; i < N; i++) {
+        CHECK(blk16[i] == out16[i], "median block, %s input: sample %d is %d, one at a time %d",
+                input_names[input], i, blk16[i], out16[i]);
+    }
+    printf(", block the same\n");
+}
+
+int main() {
+    int k, input;
+    double bound;
+
+    for (k = 0; k < FIR_TAPS; k++) {
+        fir_h[k] = Q15(fir_design(k));
+        fir32_h[k] = (int) floor(fir_design(k) * 2147483648.0 + 0.5);
+    }
+    // 4th order Butterworth low pass at 0.05 of the sample rate, as two sections
+    for (k = 0; k < SECTIONS; k++) {
+        double w = tan(M_PI * 0.05);
+        double q = 1 / (2 * cos(M_PI * (2 * k + 1) / 8));
+        double a0 = 1 + w / q + w * w;
+        bq[k].b0 = Q14(w * w / a0);
+        bq[k].b1 = Q14(2 * w * w / a0);
+        bq[k].b2 = Q14(w * w / a0);
+        bq[k].a1 = Q14(2 * (w * w - 1) / a0);
+        bq[k].a2 = Q14((1 - w / q + w * w) / a0);
+    }
+    bound = biquad_bound();
+
+    srand(9);
+    for (input = 0; input < INPUTS; input++) {
+        check_fir(input);
+        check_fir32(input);
+        check_biquad(input, bound);
+        check_average(input);
+        check_median(input);
+    }
+    return check_done("test_dsp");
+}
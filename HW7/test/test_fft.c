@@ -0,0 +1,106 @@
+// fft.c against a double precision DFT / n, for every size from 64 to 512 points:
+// two tones with noise, a full scale tone (the halving has to keep it from overflowing),
+// an impulse and full scale noise. Every bin of the fixed point result has to be within
+// log2n LSB of the reference, the truncation of each stage can lose up to about 1 LSB.
+// Also checks fft_magnitude() is within the 7% fft.h says, and fft_window() is the Hann window.
+
+#include "check.h"
+#include <math.h>
+#include <stdlib.h>
+#include "fft.h"
+
+#define SIGNALS 4
+
+static const char * signal_names[SIGNALS] = {"two tones + noise", "full scale tone", "impulse", "full scale noise"};
+
+static double sample(int signal, int i, int n) {
+    switch (signal) {
+        case 0:
+            return 12000 * sin(2 * M_PI * i * 5.0 / n) + 6000 * cos(2 * M_PI * i * 17.3 / n) + (rand() % 2001 - 1000);
+        case 1:
+            return 32767 * sin(2 * M_PI * i * (n / 8) / n);
+        case 2:
+            return i == 0 ? 32767 : 0;
+        default:
+            return rand() % 65536 - 32768;
+    }
+}
+
+// worst distance of any bin from the DFT / n, in LSB
+static double check_fft(int signal, int log2n, double * mag_err) {
+    static short re[FFT_MAX_N], im[FFT_MAX_N];
+    static short x[FFT_MAX_N];
+    static unsigned short mag[FFT_MAX_N / 2];
+    int n = 1 << log2n;
+    int i, k;
+    double r, q, worst = 0, m;
+
+    for (i = 0; i < n; i++) {
+        x[i] = (short) sample(signal, i, n);
+        re[i] = x[i];
+        im[i] = 0;
+    }
+    fft(re, im, log2n);
+    for (k = 0; k < n; k++) {
+        r = 0;
+        q = 0;
+        for (i = 0; i < n; i++) {
+            r += x[i] * cos(2 * M_PI * i * k / n);
+            q -= x[i] * sin(2 * M_PI * i * k / n);
+        }
+        r /= n;
+        q /= n;
+        worst = fmax(worst, fmax(fabs(r - re[k]), fabs(q - im[k])));
+    }
+
+    // the magnitude of the bins big enough for 7% to be more than the rounding
+    fft_magnitude(re, im, mag, n / 2);
+    *mag_err = 0;
+    for (k = 0; k < n / 2; k++) {
+        m = hypot(re[k], im[k]);
+        if (m > 50) {
+            *mag_err = fmax(*mag_err, fabs(mag[k] - m) / m);
+        }
+    }
+    return worst;
+}
+
+int main() {
+    int log2n, signal, i, n;
+    double worst, mag_err, w;
+    static short x[FFT_MAX_N];
+
+    srand(3);
+    printf("points  worst error in LSB of the DFT/n");
+    for (signal = 0; signal < SIGNALS; signal++) {
+        printf(" | %s", signal_names[signal]);
+    }
+    printf("\n");
+    for (log2n = 6; log2n <= FFT_MAX_LOG2; log2n++) {
+        printf("%6d ", 1 << log2n);
+        for (signal = 0; signal < SIGNALS; signal++) {
+            worst = check_fft(signal, log2n, &mag_err);
+            printf(" %5.2f (magnitude %4.1f%%)", worst, mag_err * 100);
+            CHECK(worst <= log2n, "%d points, %s: %.2f LSB off", 1 << log2n, signal_names[signal], worst);
+            CHECK(mag_err <= 0.07, "%d points, %s: magnitude %.1f%% off", 1 << log2n, signal_names[signal], mag_err * 100);
+        }
+        printf("\n");
+
+        // the window of a constant is the window itself, give or take the rounding of the
+        // table and the two shifts, 3 LSB
+        n = 1 << log2n;
+        for (i = 0; i < n; i++) {
+            x[i] = 32767;
+        }
+        fft_window(x, log2n);
+        for (i = 0; i < n; i++) {
+            w = 32767 * (1 - cos(2 * M_PI * i / n)) / 2;
+            CHECK(fabs(x[i] - w) <= 3, "%d point window: %d at %d, Hann is %.1f", n, x[i], i, w);
+        }
+    }
+    return check_done("test_fft");
+}
+
+// fft_drawBars() draws on the OLED, not tested here
+void ssd1306_drawPixel(unsigned char x, unsigned char y, unsigned char color) {
+}
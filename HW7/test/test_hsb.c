@@ -0,0 +1,84 @@
+// HSBtoRGB_fixed() against the float HSBtoRGB() it replaces, over every hue and sat and
+// brightness in steps of 3 (0 to 255 both included). Every channel has to be within 2 LSB of the
+// float version, which truncates where the fixed one rounds, and within 1 LSB of the exact
+// color worked out in double and rounded.
+// HSBtoRGB_rainbow() has to give HSBtoRGB_fixed() of evenly spaced hues, wrapping round the
+// wheel, for every length and a start hue past HSB_HUE_MAX.
+
+#include "check.h"
+#include <math.h>
+#include <stdlib.h>
+#include "ws2812b.h"
+
+#define STEP 3 // of sat and brightness, 255 is a multiple of it
+
+// the exact color, rounded
+static void hsb_exact(double hue, double sat, double brightness, double * rgb) {
+    int slice = (int) (hue / 60);
+    double f = hue / 60 - slice;
+    double aa = brightness * (1 - sat);
+    double bb = brightness * (1 - sat * f);
+    double cc = brightness * (1 - sat * (1 - f));
+    double v[6][3] = {
+        {brightness, cc, aa}, {bb, brightness, aa}, {aa, brightness, cc},
+        {aa, bb, brightness}, {cc, aa, brightness}, {brightness, aa, bb}
+    };
+    int k;
+    for (k = 0; k < 3; k++) {
+        rgb[k] = floor(v[slice][k] * 255 + 0.5);
+    }
+}
+
+static int channel(wsColor c, int k) {
+    return k == 0 ? c.r : k == 1 ? c.g : c.b;
+}
+
+int main() {
+    unsigned int hue;
+    int sat, bri, k, n, i, err;
+    int worst_float = 0, worst_exact = 0;
+    long long sum_float = 0, count = 0;
+    wsColor fixed, flt, c[WS2812B_MAX_LEDS];
+    double exact[3];
+
+    for (hue = 0; hue < HSB_HUE_MAX; hue++) {
+        for (sat = 0; sat <= 255; sat += STEP) {
+            for (bri = 0; bri <= 255; bri += STEP) {
+                fixed = HSBtoRGB_fixed(hue, sat, bri);
+                flt = HSBtoRGB(hue * 360.0f / HSB_HUE_MAX, sat / 255.0f, bri / 255.0f);
+                hsb_exact(hue * 360.0 / HSB_HUE_MAX, sat / 255.0, bri / 255.0, exact);
+                for (k = 0; k < 3; k++) {
+                    err = abs(channel(fixed, k) - channel(flt, k));
+                    sum_float += err;
+                    count++;
+                    if (err > worst_float) {
+                        worst_float = err;
+                    }
+                    CHECK(err <= 2, "hue %u sat %d brightness %d channel %d: %d, float has %d",
+                            hue, sat, bri, k, channel(fixed, k), channel(flt, k));
+                    err = (int) fabs(channel(fixed, k) - exact[k]);
+                    if (err > worst_exact) {
+                        worst_exact = err;
+                    }
+                    CHECK(err <= 1, "hue %u sat %d brightness %d channel %d: %d, exact is %.0f",
+                            hue, sat, bri, k, channel(fixed, k), exact[k]);
+                }
+            }
+        }
+    }
+    printf("HSBtoRGB_fixed: worst %d LSB from the float version (mean %.2f), %d from exact\n",
+            worst_float, (double) sum_float / count, worst_exact);
+
+    for (n = 1; n <= WS2812B_MAX_LEDS; n++) {
+        for (hue = 0; hue < 2 * HSB_HUE_MAX; hue += 97) {
+            HSBtoRGB_rainbow(c, n, hue, 200, 100);
+            for (i = 0; i < n; i++) {
+                fixed = HSBtoRGB_fixed((hue + i * (HSB_HUE_MAX / n)) % HSB_HUE_MAX, 200, 100);
+                CHECK(c[i].r == fixed.r && c[i].g == fixed.g && c[i].b == fixed.b,
+                        "rainbow of %d from hue %u: LED %d is %02x%02x%02x, not %02x%02x%02x",
+                        n, hue, i, c[i].r, c[i].g, c[i].b, fixed.r, fixed.g, fixed.b);
+            }
+        }
+    }
+    return check_done("test_hsb");
+}
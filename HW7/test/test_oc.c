@@ -0,0 +1,105 @@
+// Output compare mode: OC4 puts out exactly the edges of the table, and B6 stays low after the
+// last fall instead of OC4 toggling on along with Timer2. The next frame starts no sooner than
+// the reset time after the last fall. A frame longer than the edge table is refused with
+// WS2812B_TOO_MANY and nothing is sent.
+
+#include "check.h"
+#include <stdlib.h>
+#include "ws2812b.h"
+
+#define T0HTIME 19 // of ws2812b.c
+#define T1HTIME 34
+#define BITTIME 60
+#define RESET_TICKS (50 * 48) // WS2812B_RESET_US
+#define QUIET_TICKS (20 * 48000) // 20mS after the frame, 14 Timer2 wraps
+
+void ws_oc_isr(void);
+
+static unsigned long long rise[2]; // first rise of each frame
+static unsigned long long fall[2]; // last fall of each frame
+
+// sends a frame and checks its edges, returns how many there were
+static int send_frame(wsColor * c, int n, int frame) {
+    int first = sim_num_edges;
+    int i, j, k;
+    unsigned int word;
+    unsigned long long ideal;
+
+    ws2812b_oc_setColor(c, n);
+    while (ws2812b_oc_busy()) {
+        sim_wait(48);
+    }
+    sim_sync();
+    CHECK(sim_num_edges - first == 48 * n, "frame %d, %d LEDs: %d edges", frame, n, sim_num_edges - first);
+    if (sim_num_edges - first != 48 * n) {
+        return 0;
+    }
+    rise[frame] = sim_edges[first].t;
+    fall[frame] = sim_edges[sim_num_edges - 1].t;
+    CHECK((sim_pins() & 0b1000000) == 0, "B6 high after frame %d", frame);
+
+    // OC4 matches are exact, every edge is where the table says
+    ideal = rise[frame];
+    k = first;
+    for (i = 0; i < n; i++) {
+        word = ((unsigned int) c[i].r << 16) | (c[i].g << 8) | c[i].b;
+        for (j = 23; j >= 0; j--) {
+            CHECK(sim_edges[k].t == ideal && (sim_edges[k].pins & 0b1000000), "LED %d bit %d rise", i, j);
+            ideal += (word >> j & 1) ? T1HTIME : T0HTIME;
+            CHECK(sim_edges[k + 1].t == ideal && !(sim_edges[k + 1].pins & 0b1000000), "LED %d bit %d fall", i, j);
+            ideal += (word >> j & 1) ? BITTIME - T1HTIME : BITTIME - T0HTIME;
+            k += 2;
+        }
+    }
+    return 1;
+}
+
+int main() {
+    wsColor c[WS2812B_MAX_LEDS];
+    static wsColor big[WS2812B_MAX_LEDS + 1];
+    int t, i, n, edges;
+
+    srand(5);
+    for (t = 0; t < 40; t++) {
+        n = 1 + (t * 13) % WS2812B_MAX_LEDS;
+        for (i = 0; i < n; i++) {
+            c[i].r = rand();
+            c[i].g = rand();
+            c[i].b = rand();
+        }
+        sim_reset();
+        sim_dma1_isr = ws_oc_isr;
+        ws2812b_oc_setup();
+        if (!send_frame(c, n, 0)) {
+            continue;
+        }
+
+        // nothing moves on B6 until the next frame
+        edges = sim_num_edges;
+        sim_wait(QUIET_TICKS);
+        sim_sync();
+        CHECK(sim_num_edges == edges, "%d LEDs: %d edges after the frame", n, sim_num_edges - edges);
+        CHECK(T2CONbits.ON == 0 && OC4CONbits.ON == 0, "%d LEDs: Timer2 or OC4 still on", n);
+
+        // right away, the second frame has to wait for the reset itself
+        sim_reset();
+        sim_dma1_isr = ws_oc_isr;
+        ws2812b_oc_setup();
+        send_frame(c, n, 0);
+        if (send_frame(c, n, 1)) {
+            CHECK(rise[1] - fall[0] >= RESET_TICKS, "%d LEDs: %llu ticks low between frames", n, rise[1] - fall[0]);
+        }
+    }
+
+    // one LED too many
+    sim_reset();
+    sim_dma1_isr = ws_oc_isr;
+    ws2812b_oc_setup();
+    i = ws2812b_oc_setColor(big, WS2812B_MAX_LEDS + 1);
+    CHECK(i == WS2812B_TOO_MANY, "%d LEDs returned %d", WS2812B_MAX_LEDS + 1, i);
+    CHECK(!ws2812b_oc_busy(), "sending a frame that is too long");
+    sim_wait(QUIET_TICKS);
+    sim_sync();
+    CHECK(sim_num_edges == 0, "%d edges from a frame that is too long", sim_num_edges);
+    return check_done("test_oc");
+}
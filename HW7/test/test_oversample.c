@@ -0,0 +1,112 @@
+// adc_oversample() on the simulated ADC, checking the claim in adc.c: 4^n samples summed and
+// shifted right n give 10+n bits, as long as there is at least 1 LSB of noise on the input.
+// The input is a DC level between two codes plus gaussian noise, quantized like the ADC does
+// (code k from k-0.5 to k+0.5 LSB). It is swept in 1/4 LSB steps of the 10+n bit result:
+// with 1 LSB of noise the average result has to follow the input within 1 LSB of 10+n bits
+// (the shift truncates, so it sits about 0.5 LSB low), with no noise every result is the
+// 10 bit code with n zeros under it and the extra bits are worth nothing.
+// Also checks every call takes exactly 4^n conversions and puts the ADC registers back.
+
+#include "check.h"
+#include <math.h>
+#include <stdlib.h>
+#include "adc.h"
+
+#define PIN 5
+#define CALLS 256 // results averaged per input level
+#define LEVEL 600.0 // 10 bit LSBs, anywhere away from the ends
+
+static double adc_in; // input, 10 bit LSBs
+static double adc_noise; // rms, 10 bit LSBs
+static int adc_conversions;
+
+// gaussian from two uniforms (Box-Muller)
+static double gauss() {
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double v = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+}
+
+static int adc_code(int pin) {
+    double v = adc_in + adc_noise * gauss();
+    int code = (int) floor(v + 0.5);
+    CHECK(pin == PIN, "converted AN%d", pin);
+    adc_conversions++;
+    return code < 0 ? 0 : code > 1023 ? 1023 : code;
+}
+
+// sweep one 10 bit LSB and return the worst distance of the average result from the input,
+// in LSBs of the 10+n bit result
+static double sweep(int n, double noise, double * rms) {
+    int steps = 4 << n; // 1/4 LSB of the result
+    int s, k;
+    double worst = 0, err, mean, sq = 0;
+    unsigned int r;
+
+    adc_noise = noise;
+    for (s = 0; s < steps; s++) {
+        adc_in = LEVEL + (double) s / steps;
+        mean = 0;
+        for (k = 0; k < CALLS; k++) {
+            adc_conversions = 0;
+            r = adc_oversample(PIN, n);
+            CHECK(adc_conversions == 1 << (2 * n), "n=%d took %d conversions", n, adc_conversions);
+            if (noise == 0) {
+                CHECK(r == (unsigned int) floor(adc_in + 0.5) << n, "n=%d no noise: %u at %.3f LSB", n, r, adc_in);
+            }
+            mean += r;
+            err = r - adc_in * (1 << n);
+            sq += err * err;
+        }
+        mean /= CALLS;
+        err = fabs(mean - adc_in * (1 << n));
+        if (err > worst) {
+            worst = err;
+        }
+    }
+    *rms = sqrt(sq / (steps * CALLS));
+    return worst;
+}
+
+int main() {
+    int n;
+    double worst, rms, worst0, rms0;
+    unsigned int con1, con2, con3, chs;
+
+    srand(11);
+    sim_reset();
+    sim_adc = adc_code;
+    adc_setup();
+    AD1CHSbits.CH0SA = 1; // something for it to put back
+    con1 = AD1CON1;
+    con2 = AD1CON2;
+    con3 = AD1CON3;
+    chs = AD1CHS;
+
+    printf(" n  bits  samples  worst average error (LSB of 10+n bits)     rms with/without\n");
+    for (n = 1; n <= 4; n++) {
+        worst = sweep(n, 1.0, &rms);
+        worst0 = sweep(n, 0.0, &rms0);
+        printf(" %d  %4d  %7d  %5.2f with 1 LSB of noise, %5.2f without  %5.2f %5.2f\n",
+                n, 10 + n, 1 << (2 * n), worst, worst0, rms, rms0);
+        CHECK(worst <= 1.0, "n=%d: the average is %.2f LSB off with 1 LSB of noise", n, worst);
+        CHECK(worst0 > 1.0 || n == 1, "n=%d: %.2f LSB off without noise, the test isn't telling anything", n, worst0);
+        CHECK(AD1CON1 == con1 && AD1CON2 == con2 && AD1CON3 == con3 && AD1CHS == chs,
+                "n=%d: ADC registers not put back", n);
+        CHECK(!IEC0bits.AD1IE && !IFS0bits.AD1IF, "n=%d: ADC interrupt left on", n);
+    }
+    return check_done("test_oversample");
+}
+
+// the display and the I2C behind it, main() in adc.c uses them but the test doesn't
+void i2c_master_setup() {
+}
+
+void i2c_master_start() {
+}
+
+void i2c_master_send(unsigned char byte) {
+}
+
+void i2c_master_stop() {
+}
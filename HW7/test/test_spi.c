@@ -0,0 +1,73 @@
+// SPI output mode: every encoded frame decodes back to the colors it came from.
+// The bit stream is read 4 SPI bits at a time, every symbol has to be 1000 (a 0) or 1100 (a 1),
+// and the reset bytes after the last LED have to be all low.
+// A frame longer than the buffer is refused with WS2812B_TOO_MANY, and the buffer isn't touched.
+
+#include "check.h"
+#include <stdlib.h>
+#include <string.h>
+#include "ws2812b.h"
+
+#define SPI_RESET_BYTES 24 // WS2812B_SPI_RESET_BYTES of ws2812b.c
+
+static unsigned char buf[WS2812B_SPI_BYTES_PER_LED * WS2812B_MAX_LEDS + SPI_RESET_BYTES];
+
+// SPI bit k of the stream, MSB of every byte first like SPI1 shifts it out
+static int spi_bit(int k) {
+    return (buf[k / 8] >> (7 - k % 8)) & 1;
+}
+
+static void check_frame(wsColor * c, int numLEDs) {
+    int len = ws2812b_spi_encode(c, numLEDs, buf);
+    int i, k, sym;
+    unsigned int word;
+
+    CHECK(len == numLEDs * WS2812B_SPI_BYTES_PER_LED + SPI_RESET_BYTES, "%d LEDs encoded to %d bytes", numLEDs, len);
+    for (i = 0; i < numLEDs; i++) {
+        word = 0;
+        for (k = 0; k < 24; k++) {
+            int b = (i * 24 + k) * 4;
+            sym = (spi_bit(b) << 3) | (spi_bit(b + 1) << 2) | (spi_bit(b + 2) << 1) | spi_bit(b + 3);
+            CHECK(sym == 0b1000 || sym == 0b1100, "LED %d bit %d is symbol %x", i, k, sym);
+            word = (word << 1) | (sym == 0b1100);
+        }
+        CHECK(word == (((unsigned int) c[i].r << 16) | (c[i].g << 8) | c[i].b),
+                "LED %d decoded to %06x, sent %02x%02x%02x", i, word, c[i].r, c[i].g, c[i].b);
+    }
+    for (k = numLEDs * WS2812B_SPI_BYTES_PER_LED; k < len; k++) {
+        CHECK(buf[k] == 0, "reset byte %d is %02x", k, buf[k]);
+    }
+}
+
+int main() {
+    wsColor c[WS2812B_MAX_LEDS];
+    static wsColor big[WS2812B_MAX_LEDS + 1];
+    int t, i, v;
+
+    // every byte value in every color position
+    for (v = 0; v < 256; v++) {
+        c[0].r = v;
+        c[0].g = 255 - v;
+        c[0].b = v ^ 0x5A;
+        check_frame(c, 1);
+    }
+    // random frames of every length
+    srand(1);
+    for (t = 0; t < 2000; t++) {
+        int n = 1 + t % WS2812B_MAX_LEDS;
+        for (i = 0; i < n; i++) {
+            c[i].r = rand();
+            c[i].g = rand();
+            c[i].b = rand();
+        }
+        check_frame(c, n);
+    }
+    // one LED too many
+    memset(buf, 0xA5, sizeof(buf));
+    i = ws2812b_spi_encode(big, WS2812B_MAX_LEDS + 1, buf);
+    CHECK(i == WS2812B_TOO_MANY, "%d LEDs encoded to %d", WS2812B_MAX_LEDS + 1, i);
+    for (i = 0; i < (int) sizeof(buf); i++) {
+        CHECK(buf[i] == 0xA5, "byte %d of the buffer written for a frame that is too long", i);
+    }
+    return check_done("test_spi");
+}
@@ -0,0 +1,141 @@
+// Bit banged mode: ws_stream() puts out the same waveform as the delay_times buffer it replaced.
+// old_setColor() is the original ws2812b_setColor() of the class code, which only held 5 LEDs
+// (with today's bit times),
+// both are run on the simulated Timer2/LATB and every edge has to land within a poll of the
+// other. Longer frames, past the 16 bit wrap of TMR2, are checked against the ideal edge times.
+// The CTMU interrupt (T4IE) has to be off at every edge and back on after the frame, the
+// others are left alone.
+
+#include "check.h"
+#include <stdlib.h>
+#include "ws2812b.h"
+
+#define T0HTIME 19 // of ws2812b.c
+#define T1HTIME 34
+#define BITTIME 60
+#define OLD_MAX_LEDS 5
+#define SLACK (2 * SIM_READ_TICKS) // two polls, one on each side
+#define IDEAL_SLACK (3 * SIM_READ_TICKS) // and TMR2 = 0 lands one access after the first rise
+#define LONG_LEDS 300 // 432000 ticks, TMR2 wraps 6 times
+
+// the original, with the color loops folded into one
+static void old_setColor(wsColor * c, int numLEDs) {
+    int i = 0; int j = 0;
+    int numBits = 2 * 3 * 8 * numLEDs;
+    volatile unsigned int delay_times[2*3*8 * OLD_MAX_LEDS];
+    unsigned int word;
+
+    delay_times[0] = 0;
+    int nB = 1;
+    for (i = 0; i < numLEDs; i++) {
+        word = ((unsigned int) c[i].r << 16) | (c[i].g << 8) | c[i].b;
+        for (j = 23; j >= 0; j--) {
+            if (word >> j & 1) {
+                delay_times[nB] = delay_times[nB - 1] + T1HTIME;
+                nB++;
+                delay_times[nB] = delay_times[nB - 1] + BITTIME - T1HTIME;
+                nB++;
+            } else {
+                delay_times[nB] = delay_times[nB - 1] + T0HTIME;
+                nB++;
+                delay_times[nB] = delay_times[nB - 1] + BITTIME - T0HTIME;
+                nB++;
+            }
+        }
+    }
+    LATBbits.LATB6 = 1;
+    TMR2 = 0;
+    for (i = 1; i < numBits; i++) {
+        while (TMR2 < delay_times[i]) {
+        }
+        LATBINV = 0b1000000;
+    }
+    LATBbits.LATB6 = 0;
+    TMR2 = 0;
+    while(TMR2 < 2400){}
+}
+
+// the B6 edges of the last frame, in ticks from the first one, returns how many
+static int frame_edges(unsigned long long * t, int max) {
+    int i, n = 0;
+    sim_sync();
+    for (i = 0; i < sim_num_edges && n < max; i++) {
+        t[n++] = sim_edges[i].t - sim_edges[0].t;
+    }
+    return n;
+}
+
+static unsigned long long old_t[48 * OLD_MAX_LEDS + 1];
+static unsigned long long new_t[48 * LONG_LEDS + 1];
+
+static void random_frame(wsColor * c, int n) {
+    int i;
+    for (i = 0; i < n; i++) {
+        c[i].r = rand();
+        c[i].g = rand();
+        c[i].b = rand();
+    }
+}
+
+int main() {
+    static wsColor c[LONG_LEDS];
+    int t, n, i, j, k;
+    int old_n, new_n;
+    long long d;
+    unsigned int word;
+    unsigned long long ideal;
+
+    srand(3);
+    for (t = 0; t < 500; t++) {
+        n = 1 + t % OLD_MAX_LEDS;
+        random_frame(c, n);
+
+        sim_reset();
+        ws2812b_setup();
+        old_setColor(c, n);
+        old_n = frame_edges(old_t, 48 * OLD_MAX_LEDS + 1);
+
+        sim_reset();
+        ws2812b_setup();
+        ws2812b_invalidate();
+        ws2812b_setColor(c, n);
+        new_n = frame_edges(new_t, 48 * OLD_MAX_LEDS + 1);
+
+        CHECK(old_n == 48 * n && new_n == old_n, "%d LEDs: %d edges before, %d now", n, old_n, new_n);
+        for (i = 0; i < old_n && i < new_n; i++) {
+            d = (long long) new_t[i] - (long long) old_t[i];
+            CHECK(d >= -SLACK && d <= SLACK, "%d LEDs: edge %d at %llu, was %llu", n, i, new_t[i], old_t[i]);
+        }
+    }
+
+    // a long frame against the ideal times, the Timer2 wrap mustn't show
+    random_frame(c, LONG_LEDS);
+    sim_reset();
+    ws2812b_setup();
+    ws2812b_invalidate();
+    IEC0bits.T4IE = 1;
+    IEC0bits.AD1IE = 1;
+    ws2812b_setColor(c, LONG_LEDS);
+    new_n = frame_edges(new_t, 48 * LONG_LEDS + 1);
+    CHECK(new_n == 48 * LONG_LEDS, "%d LEDs: %d edges", LONG_LEDS, new_n);
+    for (k = 0; k < sim_num_edges; k++) {
+        CHECK(!(sim_edges[k].iec0 & (1 << 19)), "edge %d with the CTMU interrupt on", k);
+        CHECK(sim_edges[k].iec0 & (1 << 28), "edge %d with the ADC interrupt off", k);
+    }
+    CHECK(IEC0bits.T4IE && IEC0bits.AD1IE, "interrupts not put back after the frame");
+    ideal = 0;
+    k = 0;
+    for (i = 0; i < LONG_LEDS && k < new_n; i++) {
+        word = ((unsigned int) c[i].r << 16) | (c[i].g << 8) | c[i].b;
+        for (j = 23; j >= 0 && k + 1 < new_n; j--) {
+            d = (long long) new_t[k] - (long long) ideal;
+            CHECK(d >= -IDEAL_SLACK && d <= IDEAL_SLACK, "rise of LED %d bit %d at %llu, should be %llu", i, j, new_t[k], ideal);
+            ideal += (word >> j & 1) ? T1HTIME : T0HTIME;
+            d = (long long) new_t[k + 1] - (long long) ideal;
+            CHECK(d >= -IDEAL_SLACK && d <= IDEAL_SLACK, "fall of LED %d bit %d at %llu, should be %llu", i, j, new_t[k + 1], ideal);
+            ideal += (word >> j & 1) ? BITTIME - T1HTIME : BITTIME - T0HTIME;
+            k += 2;
+        }
+    }
+    return check_done("test_stream");
+}
@@ -0,0 +1,276 @@
+// WS2812B timing verifier. Every output mode is run on the simulated Timer2, LATB and OC4, and
+// its edges are cut into highs and lows and checked against the datasheet windows:
+// T0H 0.35uS, T0L 0.8uS, T1H 0.7uS, T1L 0.6uS, all +-0.15uS, then at least 50uS low to latch.
+// The bits are read back from the high times and have to be the colors that were sent.
+// Prints the shortest and longest of every time per mode and what a frame costs per LED: the
+// 48MHz cycles it is on the wire (the bit banged modes keep the CPU that long) and the time the
+// encoding done before the frame takes on this PC, to compare encoders with.
+// The parallel mode has to refuse a frame longer than its bit slices without sending it.
+
+#include "check.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ws2812b.h"
+
+#define LEDS WS2812B_MAX_LEDS
+#define FRAMES 20
+#define STRIPS 4
+#define PAR_PIN 10 // B10-B13
+#define SPI_TICKS 14 // 48MHz ticks per SPI bit, 2 * (WS2812B_SPI_BRG + 1)
+#define SPI_RESET_BYTES 24 // WS2812B_SPI_RESET_BYTES
+#define RESET_NS 50000
+#define NS(ticks) ((ticks) * 1000 / 48)
+
+void ws_oc_isr(void);
+
+typedef struct {
+    const char * name;
+    unsigned int min[4], max[4]; // T0H T0L T1H T1L in nS
+    unsigned long long reset; // shortest latch low, nS
+    unsigned long long wire; // 48MHz ticks on the wire, all frames
+    long long leds; // LEDs sent, all frames
+    double encode_ns; // per LED on this PC, 0 if it doesn't encode ahead
+} modeStats;
+
+static const char * time_names[4] = {"T0H", "T0L", "T1H", "T1L"};
+static const unsigned int time_typ[4] = {350, 800, 700, 600};
+
+static unsigned long long edge_t[2 * 24 * LEDS + 2]; // one pin's edges
+static wsColor frame[STRIPS][LEDS];
+
+static void stats_start(modeStats * m, const char * name) {
+    int k;
+    m->name = name;
+    for (k = 0; k < 4; k++) {
+        m->min[k] = ~0u;
+        m->max[k] = 0;
+    }
+    m->reset = ~0ull;
+    m->wire = 0;
+    m->leds = 0;
+    m->encode_ns = 0;
+}
+
+static void stats_add(modeStats * m, int k, unsigned int ns) {
+    if (ns < m->min[k]) {
+        m->min[k] = ns;
+    }
+    if (ns > m->max[k]) {
+        m->max[k] = ns;
+    }
+    CHECK(ns + 150 >= time_typ[k] && ns <= time_typ[k] + 150, "%s: %s of %unS", m->name, time_names[k], ns);
+}
+
+// the recorded edges of pin p from edge first on, returns how many
+static int pin_edges(int p, int first, unsigned long long * t, int max) {
+    int i, n = 0;
+    unsigned int last = first > 0 ? sim_edges[first - 1].pins : 0;
+    for (i = first; i < sim_num_edges && n < max; i++) {
+        if ((sim_edges[i].pins ^ last) & (1u << p)) {
+            t[n++] = sim_edges[i].t;
+        }
+        last = sim_edges[i].pins;
+    }
+    return n;
+}
+
+// checks one frame of edges (a rise and a fall per bit) against the colors,
+// end is when the line goes high again or the latch low is over
+static void check_frame(modeStats * m, const unsigned long long * t, int n, const wsColor * c, int numLEDs,
+        unsigned long long end) {
+    int i, j, k = 0;
+    unsigned int word, high, low;
+    int bit;
+
+    CHECK(n == 48 * numLEDs, "%s: %d edges for %d LEDs", m->name, n, numLEDs);
+    if (n != 48 * numLEDs) {
+        return;
+    }
+    for (i = 0; i < numLEDs; i++) {
+        word = ((unsigned int) c[i].r << 16) | (c[i].g << 8) | c[i].b;
+        for (j = 23; j >= 0; j--) {
+            high = NS(t[k + 1] - t[k]);
+            bit = high > 500; // the LED's own threshold is about halfway between T0H and T1H
+            CHECK(bit == ((word >> j) & 1), "%s: LED %d bit %d read as %d", m->name, i, j, bit);
+            stats_add(m, bit ? 2 : 0, high);
+            if (k + 2 < n) {
+                low = NS(t[k + 2] - t[k + 1]);
+                stats_add(m, bit ? 3 : 1, low);
+            }
+            k += 2;
+        }
+    }
+    // the last low is the latch
+    if (NS(end - t[n - 1]) < m->reset) {
+        m->reset = NS(end - t[n - 1]);
+    }
+    m->wire += t[n - 1] - t[0];
+    m->leds += numLEDs;
+}
+
+static void random_frames(int strips, int n) {
+    int s, i;
+    for (s = 0; s < strips; s++) {
+        for (i = 0; i < n; i++) {
+            frame[s][i].r = rand();
+            frame[s][i].g = rand();
+            frame[s][i].b = rand();
+        }
+    }
+}
+
+static double now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void run_bitbang(modeStats * m) {
+    int f, n;
+    stats_start(m, "bit banged");
+    for (f = 0; f < FRAMES; f++) {
+        random_frames(1, LEDS);
+        sim_reset();
+        ws2812b_setup();
+        ws2812b_invalidate();
+        ws2812b_setColor(frame[0], LEDS);
+        sim_sync();
+        n = pin_edges(6, 0, edge_t, 48 * LEDS + 2);
+        check_frame(m, edge_t, n, frame[0], LEDS, sim_ticks); // returns after the latch
+    }
+}
+
+static void run_spi(modeStats * m) {
+    static unsigned char buf[WS2812B_SPI_BYTES_PER_LED * LEDS + SPI_RESET_BYTES];
+    int f, k, n, len, level, bit;
+    double start;
+
+    stats_start(m, "SPI + DMA");
+    for (f = 0; f < FRAMES; f++) {
+        random_frames(1, LEDS);
+        len = ws2812b_spi_encode(frame[0], LEDS, buf);
+        // SDO1 holds every bit for one SPI clock, MSB first
+        n = 0;
+        level = 0;
+        for (k = 0; k < len * 8; k++) {
+            bit = (buf[k / 8] >> (7 - k % 8)) & 1;
+            if (bit != level && n < 48 * LEDS + 2) {
+                edge_t[n++] = (unsigned long long) k * SPI_TICKS;
+            }
+            level = bit;
+        }
+        CHECK(level == 0, "SPI: line high at the end");
+        check_frame(m, edge_t, n, frame[0], LEDS, (unsigned long long) len * 8 * SPI_TICKS);
+    }
+    start = now_ns();
+    for (f = 0; f < 1000; f++) {
+        ws2812b_spi_encode(frame[0], LEDS, buf);
+    }
+    m->encode_ns = (now_ns() - start) / (1000.0 * LEDS);
+}
+
+static void run_oc(modeStats * m) {
+    static wsColor last[LEDS];
+    static unsigned long long last_t[2 * 24 * LEDS + 2];
+    int f, n, last_n = 0, first;
+    double start;
+
+    stats_start(m, "OC4 + DMA");
+    sim_reset();
+    sim_dma1_isr = ws_oc_isr;
+    ws2812b_oc_setup();
+    // each frame is checked once the next one starts, that is where its latch ends
+    for (f = 0; f <= FRAMES; f++) {
+        random_frames(1, LEDS);
+        first = sim_num_edges;
+        ws2812b_oc_setColor(frame[0], LEDS);
+        while (ws2812b_oc_busy()) {
+            sim_wait(48);
+        }
+        sim_sync();
+        n = pin_edges(6, first, edge_t, 48 * LEDS + 2);
+        if (f > 0 && n > 0) {
+            check_frame(m, last_t, last_n, last, LEDS, edge_t[0]);
+        }
+        memcpy(last_t, edge_t, sizeof(edge_t));
+        memcpy(last, frame[0], sizeof(last));
+        last_n = n;
+    }
+    start = now_ns();
+    for (f = 0; f < 1000; f++) {
+        ws2812b_oc_encode(frame[0], LEDS);
+    }
+    m->encode_ns = (now_ns() - start) / (1000.0 * LEDS);
+}
+
+static void run_par(modeStats * m) {
+    wsColor * strips[STRIPS];
+    int f, s, n;
+    double start;
+
+    stats_start(m, "parallel x4");
+    for (s = 0; s < STRIPS; s++) {
+        strips[s] = frame[s];
+    }
+    for (f = 0; f < FRAMES; f++) {
+        random_frames(STRIPS, LEDS);
+        sim_reset();
+        ws2812b_par_setup(PAR_PIN, STRIPS);
+        ws2812b_par_setColor(strips, LEDS);
+        sim_sync();
+        for (s = 0; s < STRIPS; s++) {
+            n = pin_edges(PAR_PIN + s, 0, edge_t, 48 * LEDS + 2);
+            check_frame(m, edge_t, n, frame[s], LEDS, sim_ticks);
+        }
+    }
+    start = now_ns();
+    for (f = 0; f < 1000; f++) {
+        ws2812b_par_encode(strips, LEDS);
+    }
+    m->encode_ns = (now_ns() - start) / (1000.0 * LEDS * STRIPS);
+
+    // one LED too many is refused, strips that are all off so nothing past them is read
+    for (s = 0; s < STRIPS; s++) {
+        strips[s] = 0;
+    }
+    sim_reset();
+    ws2812b_par_setup(PAR_PIN, STRIPS);
+    n = ws2812b_par_setColor(strips, LEDS + 1);
+    sim_sync();
+    CHECK(n == WS2812B_TOO_MANY, "parallel: %d LEDs returned %d", LEDS + 1, n);
+    CHECK(sim_num_edges == 0, "parallel: %d edges from a frame that is too long", sim_num_edges);
+}
+
+int main() {
+    modeStats modes[4];
+    int i, k;
+
+    srand(7);
+    run_bitbang(&modes[0]);
+    run_spi(&modes[1]);
+    run_oc(&modes[2]);
+    run_par(&modes[3]);
+
+    printf("%-12s", "mode");
+    for (k = 0; k < 4; k++) {
+        printf(" %3s nS    ", time_names[k]);
+    }
+    printf(" latch uS  cycles/LED  encode nS/LED on this PC\n");
+    for (i = 0; i < 4; i++) {
+        modeStats * m = &modes[i];
+        printf("%-12s", m->name);
+        for (k = 0; k < 4; k++) {
+            printf(" %4u-%-4u  ", m->min[k], m->max[k]);
+        }
+        printf(" %7.1f  %10.0f", m->reset / 1000.0, m->leds ? (double) m->wire / m->leds : 0.0);
+        if (m->encode_ns > 0) {
+            printf("  %.1f", m->encode_ns);
+        } else {
+            printf("  - (encodes while sending)");
+        }
+        printf("\n");
+        CHECK(m->reset >= RESET_NS, "%s: latch low of only %lluS", m->name, m->reset);
+    }
+    return check_done("test_timing");
+}
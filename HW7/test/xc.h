@@ -0,0 +1,191 @@
+#ifndef XC_H__
+#define XC_H__
+
+// Host stand-in for the XC32 <xc.h>: the registers the HW7 drivers touch, as plain variables
+// with the same bit fields, plus the hooks of sim.h for the ones with timing or side effects.
+// Bit positions match the PIC32MX170F256B where a whole register is written or masked.
+
+#include "sim.h"
+
+#ifdef SIM_DEFINE
+#define SIM_SFR(name, fields) volatile union { unsigned int w; struct { fields } bits; } sim_##name;
+#else
+#define SIM_SFR(name, fields) extern volatile union { unsigned int w; struct { fields } bits; } sim_##name;
+#endif
+
+#define SIM_TIMER(n) \
+    SIM_SFR(T##n##CON, unsigned :1; unsigned TCS:1; unsigned :1; unsigned T32:1; unsigned TCKPS:3; unsigned TGATE:1; unsigned :5; unsigned SIDL:1; unsigned :1; unsigned ON:1;) \
+    SIM_SFR(PR##n, unsigned PR##n:16;)
+SIM_TIMER(2)
+SIM_TIMER(3)
+SIM_TIMER(4)
+SIM_SFR(TMR3, unsigned TMR3:16;)
+SIM_SFR(TMR4, unsigned TMR4:16;)
+SIM_SFR(TRISA, unsigned TRISA0:1; unsigned TRISA1:1; unsigned TRISA2:1; unsigned TRISA3:1; unsigned TRISA4:1;)
+SIM_SFR(LATA, unsigned LATA0:1; unsigned LATA1:1; unsigned LATA2:1; unsigned LATA3:1; unsigned LATA4:1;)
+SIM_SFR(TRISB, unsigned TRISB0:1; unsigned TRISB1:1; unsigned TRISB2:1; unsigned TRISB3:1; unsigned TRISB4:1; unsigned TRISB5:1; unsigned TRISB6:1; unsigned TRISB7:1; unsigned TRISB8:1; unsigned TRISB9:1; unsigned TRISB10:1; unsigned TRISB11:1; unsigned TRISB12:1; unsigned TRISB13:1; unsigned TRISB14:1; unsigned TRISB15:1;)
+SIM_SFR(ANSELB, unsigned ANSB0:1; unsigned ANSB1:1; unsigned ANSB2:1; unsigned ANSB3:1;)
+SIM_SFR(LATB, unsigned LATB0:1; unsigned LATB1:1; unsigned LATB2:1; unsigned LATB3:1; unsigned LATB4:1; unsigned LATB5:1; unsigned LATB6:1; unsigned LATB7:1; unsigned LATB8:1; unsigned LATB9:1; unsigned LATB10:1; unsigned LATB11:1; unsigned LATB12:1; unsigned LATB13:1; unsigned LATB14:1; unsigned LATB15:1;)
+SIM_SFR(PORTB, unsigned RB0:1; unsigned RB1:1; unsigned RB2:1; unsigned RB3:1; unsigned RB4:1; unsigned RB5:1; unsigned RB6:1; unsigned RB7:1; unsigned RB8:1; unsigned RB9:1; unsigned RB10:1; unsigned RB11:1; unsigned RB12:1; unsigned RB13:1; unsigned RB14:1; unsigned RB15:1;)
+SIM_SFR(RPB6R, unsigned RPB6R:4;)
+
+SIM_SFR(SPI1CON, unsigned SRXISEL:2; unsigned STXISEL:2; unsigned DISSDI:1; unsigned MSTEN:1; unsigned CKP:1; unsigned SSEN:1; unsigned CKE:1; unsigned SMP:1; unsigned MODE16:1; unsigned MODE32:1; unsigned DISSDO:1; unsigned SIDL:1; unsigned :1; unsigned ON:1; unsigned ENHBUF:1;)
+SIM_SFR(SPI1STAT, unsigned SPIRBF:1; unsigned SPITBF:1; unsigned :1; unsigned SPITBE:1; unsigned :1; unsigned SPIRBE:1; unsigned SPIROV:1; unsigned SRMT:1;)
+SIM_SFR(SPI1BUF, unsigned DATA:32;)
+SIM_SFR(SPI1BRG, unsigned BRG:13;)
+
+SIM_SFR(DMACON, unsigned :11; unsigned DMABUSY:1; unsigned SUSPEND:1; unsigned :2; unsigned ON:1;)
+#define SIM_DMA_CHANNEL(n) \
+    SIM_SFR(DCH##n##CON, unsigned CHPRI:2; unsigned CHEDET:1; unsigned :1; unsigned CHAEN:1; unsigned CHCHN:1; unsigned CHAED:1; unsigned CHEN:1; unsigned CHCHNS:1; unsigned :6; unsigned CHBUSY:1;) \
+    SIM_SFR(DCH##n##ECON, unsigned :3; unsigned AIRQEN:1; unsigned SIRQEN:1; unsigned PATEN:1; unsigned CABORT:1; unsigned CFORCE:1; unsigned CHSIRQ:8; unsigned CHAIRQ:8;) \
+    SIM_SFR(DCH##n##INT, unsigned CHERIF:1; unsigned CHTAIF:1; unsigned CHCCIF:1; unsigned CHBCIF:1; unsigned CHDHIF:1; unsigned CHDDIF:1; unsigned CHSHIF:1; unsigned CHSDIF:1; unsigned :8; unsigned CHERIE:1; unsigned CHTAIE:1; unsigned CHCCIE:1; unsigned CHBCIE:1; unsigned CHDHIE:1; unsigned CHDDIE:1; unsigned CHSHIE:1; unsigned CHSDIE:1;) \
+    SIM_SFR(DCH##n##SSA, unsigned CHSSA:32;) \
+    SIM_SFR(DCH##n##DSA, unsigned CHDSA:32;) \
+    SIM_SFR(DCH##n##SSIZ, unsigned CHSSIZ:16;) \
+    SIM_SFR(DCH##n##DSIZ, unsigned CHDSIZ:16;) \
+    SIM_SFR(DCH##n##CSIZ, unsigned CHCSIZ:16;)
+SIM_DMA_CHANNEL(0)
+SIM_DMA_CHANNEL(1)
+SIM_DMA_CHANNEL(2)
+
+SIM_SFR(OC4CON, unsigned OCM:3; unsigned OCTSEL:1; unsigned OCFLT:1; unsigned OC32:1; unsigned :7; unsigned SIDL:1; unsigned :1; unsigned ON:1;)
+SIM_SFR(OC4R, unsigned OC4R:32;)
+
+SIM_SFR(AD1CON1, union { struct { unsigned DONE:1; unsigned SAMP:1; unsigned ASAM:1; unsigned :1; unsigned CLRASAM:1; unsigned SSRC:3; unsigned FORM:3; unsigned :2; unsigned SIDL:1; unsigned :1; unsigned ON:1; };
+    struct { unsigned :15; unsigned ADON:1; }; };) // ADON is another name for ON, like in the XC32 header
+SIM_SFR(AD1CON2, unsigned ALTS:1; unsigned BUFM:1; unsigned SMPI:4; unsigned :1; unsigned BUFS:1; unsigned :2; unsigned CSCNA:1; unsigned :1; unsigned OFFCAL:1; unsigned VCFG:3;)
+SIM_SFR(AD1CON3, unsigned ADCS:8; unsigned SAMC:5; unsigned :2; unsigned ADRC:1;)
+SIM_SFR(AD1CHS, unsigned :16; unsigned CH0SA:4; unsigned :3; unsigned CH0NA:1; unsigned CH0SB:4; unsigned :3; unsigned CH0NB:1;)
+SIM_SFR(AD1CSSL, unsigned CSSL:16;)
+SIM_SFR(CTMUCON, unsigned IRNG:2; unsigned ITRIM:6; unsigned CTTRIG:1; unsigned IDISSEN:1; unsigned EDGSEQEN:1; unsigned EDGEN:1; unsigned TGEN:1; unsigned CTMUSIDL:1; unsigned :1; unsigned ON:1; unsigned :2; unsigned EDG1SEL:4; unsigned EDG2POL:1; unsigned EDG2SEL:4; unsigned EDG1POL:1; unsigned EDG2STAT:1; unsigned EDG1STAT:1;)
+
+// interrupt bits where the PIC32MX1xx/2xx vector table has them
+SIM_SFR(IFS0, unsigned :19; unsigned T4IF:1; unsigned :2; unsigned OC4IF:1; unsigned :5; unsigned AD1IF:1;)
+SIM_SFR(IEC0, unsigned :19; unsigned T4IE:1; unsigned :2; unsigned OC4IE:1; unsigned :5; unsigned AD1IE:1;)
+SIM_SFR(IFS1, unsigned :28; unsigned DMA0IF:1; unsigned DMA1IF:1; unsigned DMA2IF:1; unsigned DMA3IF:1;)
+SIM_SFR(IEC1, unsigned :28; unsigned DMA0IE:1; unsigned DMA1IE:1; unsigned DMA2IE:1; unsigned DMA3IE:1;)
+SIM_SFR(IPC4, unsigned T4IS:2; unsigned T4IP:3;)
+SIM_SFR(IPC5, unsigned :24; unsigned AD1IS:2; unsigned AD1IP:3;)
+SIM_SFR(IPC10, unsigned DMA0IS:2; unsigned DMA0IP:3; unsigned :3; unsigned DMA1IS:2; unsigned DMA1IP:3; unsigned :3; unsigned DMA2IS:2; unsigned DMA2IP:3; unsigned :3; unsigned DMA3IS:2; unsigned DMA3IP:3;)
+SIM_SFR(INTCON, unsigned :12; unsigned MVEC:1;)
+SIM_SFR(BMXCON, unsigned :6; unsigned BMXWSDRM:1;)
+SIM_SFR(DDPCON, unsigned :3; unsigned JTAGEN:1;)
+
+// ADC1BUF0-F are 16 bytes apart, 4 words of this array
+#ifdef SIM_DEFINE
+volatile unsigned int sim_ADC1BUF[64];
+#else
+extern volatile unsigned int sim_ADC1BUF[64];
+#endif
+
+// plain registers
+#define T2CON sim_T2CON.w
+#define T2CONbits sim_T2CON.bits
+#define PR2 sim_PR2.w
+#define T3CON sim_T3CON.w
+#define T3CONbits sim_T3CON.bits
+#define PR3 sim_PR3.w
+#define TMR3 sim_TMR3.w
+#define T4CON sim_T4CON.w
+#define T4CONbits sim_T4CON.bits
+#define PR4 sim_PR4.w
+#define TMR4 sim_TMR4.w
+#define TRISASET (*sim_op(&sim_TRISA.w, SIM_SET))
+#define TRISACLR (*sim_op(&sim_TRISA.w, SIM_CLR))
+#define LATACLR (*sim_op(&sim_LATA.w, SIM_CLR))
+#define TRISB sim_TRISB.w
+#define TRISBbits sim_TRISB.bits
+#define TRISBSET (*sim_op(&sim_TRISB.w, SIM_SET))
+#define TRISBCLR (*sim_op(&sim_TRISB.w, SIM_CLR))
+#define ANSELB sim_ANSELB.w
+#define ANSELBCLR (*sim_op(&sim_ANSELB.w, SIM_CLR))
+#define RPB6Rbits sim_RPB6R.bits
+#define SPI1CON sim_SPI1CON.w
+#define SPI1CONbits sim_SPI1CON.bits
+#define SPI1STATbits sim_SPI1STAT.bits
+#define SPI1BUF sim_SPI1BUF.w
+#define SPI1BRG sim_SPI1BRG.w
+#define DMACONbits sim_DMACON.bits
+#define DCH0CON sim_DCH0CON.w
+#define DCH0CONbits sim_DCH0CON.bits
+#define DCH0ECON sim_DCH0ECON.w
+#define DCH0ECONbits sim_DCH0ECON.bits
+#define DCH0INTCLR (*sim_op(&sim_DCH0INT.w, SIM_CLR))
+#define DCH0SSA sim_DCH0SSA.w
+#define DCH0DSA sim_DCH0DSA.w
+#define DCH0SSIZ sim_DCH0SSIZ.w
+#define DCH0DSIZ sim_DCH0DSIZ.w
+#define DCH0CSIZ sim_DCH0CSIZ.w
+#define DCH1CON sim_DCH1CON.w
+#define DCH1CONbits sim_DCH1CON.bits
+#define DCH1ECON sim_DCH1ECON.w
+#define DCH1ECONbits sim_DCH1ECON.bits
+#define DCH1INTbits sim_DCH1INT.bits
+#define DCH1INTCLR (*sim_op(&sim_DCH1INT.w, SIM_CLR))
+#define DCH1SSA sim_DCH1SSA.w
+#define DCH1DSA sim_DCH1DSA.w
+#define DCH1SSIZ sim_DCH1SSIZ.w
+#define DCH1DSIZ sim_DCH1DSIZ.w
+#define DCH1CSIZ sim_DCH1CSIZ.w
+#define DCH2CON sim_DCH2CON.w
+#define DCH2CONbits sim_DCH2CON.bits
+#define DCH2ECON sim_DCH2ECON.w
+#define DCH2ECONbits sim_DCH2ECON.bits
+#define DCH2INTbits sim_DCH2INT.bits
+#define DCH2INTCLR (*sim_op(&sim_DCH2INT.w, SIM_CLR))
+#define DCH2SSA sim_DCH2SSA.w
+#define DCH2DSA sim_DCH2DSA.w
+#define DCH2SSIZ sim_DCH2SSIZ.w
+#define DCH2DSIZ sim_DCH2DSIZ.w
+#define DCH2CSIZ sim_DCH2CSIZ.w
+#define _DCH2INT_CHDHIF_MASK (1u << 4)
+#define _DCH2INT_CHDDIF_MASK (1u << 5)
+#define AD1CON1 sim_AD1CON1.w
+#define AD1CON1bits sim_AD1CON1.bits
+#define AD1CON2 sim_AD1CON2.w
+#define AD1CON2bits sim_AD1CON2.bits
+#define AD1CON3 sim_AD1CON3.w
+#define AD1CON3bits sim_AD1CON3.bits
+#define AD1CHS sim_AD1CHS.w
+#define AD1CHSbits sim_AD1CHS.bits
+#define AD1CSSL sim_AD1CSSL.w
+#define ADC1BUF0 sim_ADC1BUF[0]
+#define ADC1BUF8 sim_ADC1BUF[32]
+#define CTMUCONbits sim_CTMUCON.bits
+#define OC4CON sim_OC4CON.w
+#define OC4CONbits sim_OC4CON.bits
+#define OC4R sim_OC4R.w
+#define IEC0bits sim_IEC0.bits
+#define IFS1bits sim_IFS1.bits
+#define IEC1bits sim_IEC1.bits
+#define IPC4bits sim_IPC4.bits
+#define IPC5bits sim_IPC5.bits
+#define IPC10bits sim_IPC10.bits
+#define INTCONbits sim_INTCON.bits
+#define BMXCONbits sim_BMXCON.bits
+#define DDPCONbits sim_DDPCON.bits
+
+// registers with timing or side effects go through the simulation
+#define TMR2 (*sim_tmr2())
+#define LATB (((volatile union { unsigned int w; } *) sim_latb())->w)
+#define LATBbits (*(volatile __typeof__(sim_LATB.bits) *) sim_latb())
+#define LATBSET (*sim_op(&sim_LATB.w, SIM_SET))
+#define LATBCLR (*sim_op(&sim_LATB.w, SIM_CLR))
+#define LATBINV (*sim_op(&sim_LATB.w, SIM_INV))
+#define PORTBbits (*(volatile __typeof__(sim_PORTB.bits) *) sim_portb())
+#define IFS0bits (*(volatile __typeof__(sim_IFS0.bits) *) sim_ifs0()) // the ADC flag is polled
+#define _CP0_GET_COUNT() sim_cp0()
+#define _CP0_SET_COUNT(v) ((void) (v)) // only the startup delays set it, not simulated
+#define _CP0_CONFIG 16
+#define _CP0_CONFIG_SELECT 0
+#define __builtin_mtc0(reg, sel, value) ((void) (value))
+
+// interrupt sources the DMA can start on, only OC4 is simulated
+#define _OUTPUT_COMPARE_4_IRQ 22
+#define _ADC_IRQ 28
+#define _SPI1_TX_IRQ 38
+
+#define __builtin_disable_interrupts() (0u)
+#define __builtin_enable_interrupts() ((void) 0)
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef TOUCH_H__
+#define TOUCH_H__
+
+#include <xc.h>
+
+// Touch processing of the CTMU counts, integer math only.
+// Every electrode has a baseline that slowly follows its count (IIR), so drift from
+// temperature and humidity doesn't need a reboot to recalibrate. The baseline stops while
+// the electrode is touched, so a long press isn't learned as the new baseline. If it stays
+// touched for TOUCH_MAX_ON updates, the baseline is taken to be wrong and reset to the count.
+// delta = baseline - count is how hard an electrode is touched. It turns on above TOUCH_ON,
+// off below TOUCH_OFF (hysteresis), and only after TOUCH_DEBOUNCE updates in a row.
+// All the electrodes together make a slider (or a wheel) whose position is the centroid of
+// the deltas, 0 to TOUCH_POS_SCALE per electrode gap, and it reports down/move/up events.
+
+#define TOUCH_MAX_ELECTRODES 4
+#define TOUCH_ON 5 // delta counts to turn an electrode on
+#define TOUCH_OFF 3 // and to turn it off again
+#define TOUCH_SLIDER_ON 20 // total delta of all electrodes to touch the slider
+#define TOUCH_SLIDER_OFF 12
+#define TOUCH_DEBOUNCE 3 // updates in a row before a change counts
+#define TOUCH_BASELINE_SHIFT 6 // baseline follows the count over about 2^6 updates
+#define TOUCH_RECOVER_SHIFT 2 // and faster when the count goes above it
+#define TOUCH_MAX_ON 1000 // updates on in a row before an electrode is taken as stuck and recalibrated
+#define TOUCH_POS_SCALE 256 // position steps between two electrodes
+#define TOUCH_MOVE_MIN 4 // position change that makes a move event
+
+#define TOUCH_EVENT_NONE 0
+#define TOUCH_EVENT_DOWN 1
+#define TOUCH_EVENT_MOVE 2
+#define TOUCH_EVENT_UP 3
+
+void touch_setup(int numElectrodes, int wheel); // wheel 1 if the last electrode is next to the first
+void touch_calibrate(const int * counts); // baselines = these counts
+int touch_update(const int * counts); // one count per electrode, returns a TOUCH_EVENT
+int touch_isTouched(int i); // electrode i on, after hysteresis and debounce
+int touch_delta(int i); // baseline - count, 0 if the count is above the baseline
+int touch_baseline(int i);
+int touch_position(void); // slider position, -1 if it isn't touched
+
+#endif
@@ -2,11 +2,42 @@
 
 #include "ws2812b.h"
 #include<sys/attribs.h>
+#include<sys/kmem.h> // KVA_TO_PA for the DMA addresses
 // other includes if necessary for debugging
 
 // Timer2 delay times, you can tune these if necessary
-#define LOWTIME 15 // number of 48MHz cycles to be low for 0.35uS
-#define HIGHTIME 65 // number of 48MHz cycles to be high for 1.65uS
+// a 0 is T0HTIME high and the rest of BITTIME low, a 1 is T1HTIME high and the rest low
+#define T0HTIME 19 // number of 48MHz cycles, 19/48MHz = 0.40uS
+#define T1HTIME 34 // number of 48MHz cycles, 34/48MHz = 0.71uS
+#define BITTIME 60 // a whole bit, 60/48MHz = 1.25uS
+#define WS2812B_JITTER 4 // Timer2 ticks an edge can be late, one TMR2 read of the polling loop
+#define WS2812B_RESET_US 50 // low time that latches the colors, use 280 for the newer WS2812B-V5
+#define WS2812B_RESET_TICKS (WS2812B_RESET_US * 48) // in Timer2 ticks
+
+// Check the timing against the WS2812B datasheet when it compiles, times in nS.
+// Every high and low has to stay inside its window, 150nS either side of the typical time,
+// even with its two edges WS2812B_JITTER apart the wrong way:
+// T0H 0.35uS, T0L 0.8uS, T1H 0.7uS, T1L 0.6uS. test/test_timing.c checks the real edges.
+#define WS_NS(ticks) ((ticks) * 1000 / 48)
+#define WS_OUTSIDE(ticks, typ) (WS_NS((ticks) - WS2812B_JITTER) < (typ) - 150 || WS_NS((ticks) + WS2812B_JITTER) > (typ) + 150)
+#if WS_OUTSIDE(T0HTIME, 350)
+#error "T0HTIME is outside the 0.35+-0.15uS T0H window"
+#endif
+#if WS_OUTSIDE(BITTIME - T0HTIME, 800)
+#error "BITTIME - T0HTIME is outside the 0.8+-0.15uS T0L window"
+#endif
+#if WS_OUTSIDE(T1HTIME, 700)
+#error "T1HTIME is outside the 0.7+-0.15uS T1H window"
+#endif
+#if WS_OUTSIDE(BITTIME - T1HTIME, 600)
+#error "BITTIME - T1HTIME is outside the 0.6+-0.15uS T1L window"
+#endif
+#if WS2812B_RESET_US < 50
+#error "the reset has to be at least 50uS low"
+#endif
+#if WS2812B_RESET_TICKS > 65535
+#error "the reset doesn't fit in the 16 bit Timer2"
+#endif
 
 wsColor HSBtoRGB(float hue, float sat, float brightness);
 
@@ -22,89 +53,663 @@ void ws2812b_setup() {
     LATBbits.LATB6 = 0;
 }
 
-// build an array of high/low times from the color input array, then output the high/low bits
-void ws2812b_setColor(wsColor * c, int numLEDs) {
-    int i = 0; int j = 0; // for loops
-    int numBits = 2 * 3 * 8 * numLEDs; // the number of high/low bits to store, 2 per color bit
-    volatile unsigned int delay_times[2*3*8 * 5]; // I only gave you 5 WS2812B, adjust this if you get more somewhere
+// wait until Timer2 reaches t, the 16 bit difference keeps working when TMR2 wraps
+#define WAIT_TMR2(t) while ((short)(TMR2 - (t)) < 0) {}
+// pack the 3 colors of an LED into 24 bits, sent MSB first
+#define WS_PACK(c) (((unsigned int)(c).r << 16) | ((unsigned int)(c).g << 8) | (c).b)
 
-    // start at time at 0
-    delay_times[0] = 0;
-    
-    int nB = 1; // which high/low bit you are storing, 2 per color bit, 24 color bits per WS2812B
-    // loop through each WS2812B
-    for (i = 0; i < numLEDs; i++) {
-        // loop through each color bit, MSB(Most Significant Bit) first
-        for (j = 7; j >= 0; j--) {
-            // if the bit is a 1
-            if (c[i].r>>j & 1 == 1) {
-                // the high is longer
-                delay_times[nB] = delay_times[nB - 1] + HIGHTIME;
-                nB++;
-                delay_times[nB] = delay_times[nB - 1] + LOWTIME;
-                nB++;
-            } 
-            // if the bit is a 0
-            else {
-                // the low is longer
-                delay_times[nB] = delay_times[nB - 1] + LOWTIME;
-                nB++;
-                delay_times[nB] = delay_times[nB - 1] + HIGHTIME;
-                nB++;
+// Change detection: a hash of the last frame sent is kept, and a frame with the same
+// hash is not sent again, unless the refresh period has gone by since it was last sent.
+// The WS2812Bs hold their colors, so this only costs anything if noise corrupted a frame,
+// and the refresh puts that right.
+unsigned int ws_sent_hash = 0; // hash of the last frame sent
+int ws_sent_leds = 0; // numLEDs of the last frame sent
+unsigned int ws_sent_time = 0; // core timer when it was sent
+unsigned int ws_refresh_ticks = 24000000; // resend an unchanged frame after 1s
+int ws_sent_valid = 0; // 0 to send the next frame no matter what
+
+// FNV-1a of len bytes, continuing from h (2166136261 to start)
+static unsigned int ws_hash(unsigned int h, const void * data, int len) {
+    const unsigned char * p = (const unsigned char *) data;
+    int i;
+    for (i = 0; i < len; i++) {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    return h;
+}
+
+// resend an unchanged frame after ms, 0 to send every frame
+void ws2812b_setRefresh(unsigned int ms) {
+    ws_refresh_ticks = ms * 24000; // core timer runs at 24MHz
+}
+
+// the next frame is sent even if it didn't change
+void ws2812b_invalidate() {
+    ws_sent_valid = 0;
+}
+
+// Pixel formats: the frame is kept in whatever format the caller has and every LED is
+// expanded to its 24 wire bits only as it is sent, by a fetch function for the format.
+typedef struct {
+    const void * pixels;
+    const wsColor * palette;
+} wsFrame;
+typedef unsigned int (*wsFetch)(const wsFrame * f, int i); // WS_PACK bits of LED i
+
+static unsigned int ws_fetchColor(const wsFrame * f, int i) {
+    return WS_PACK(((const wsColor *) f->pixels)[i]);
+}
+
+// 5 and 6 bit colors are scaled to 8 bits by repeating their top bits
+static unsigned int ws_fetch565(const wsFrame * f, int i) {
+    unsigned int v = ((const unsigned short *) f->pixels)[i];
+    unsigned int r = (v >> 11) & 0x1F;
+    unsigned int g = (v >> 5) & 0x3F;
+    unsigned int b = v & 0x1F;
+    r = (r << 3) | (r >> 2);
+    g = (g << 2) | (g >> 4);
+    b = (b << 3) | (b >> 2);
+    return (r << 16) | (g << 8) | b;
+}
+
+static unsigned int ws_fetchPal8(const wsFrame * f, int i) {
+    return WS_PACK(f->palette[((const unsigned char *) f->pixels)[i]]);
+}
+
+// two LEDs a byte, the even LED in the low nibble
+static unsigned int ws_fetchPal4(const wsFrame * f, int i) {
+    unsigned char v = ((const unsigned char *) f->pixels)[i >> 1];
+    return WS_PACK(f->palette[(v >> ((i & 1) << 2)) & 0x0F]);
+}
+
+// output the high/low bits, fetching every LED from the frame just before it is sent.
+// The next edge time is worked out while waiting for the current one, so there is
+// no delay_times buffer: RAM use is only the frame itself and any numLEDs works.
+// The next LED is fetched during the long part of bit 23, 34 Timer2 ticks or more, which
+// is plenty for any of the fetch functions.
+// test/test_stream.c checks the edges against the old delay_times version on the PC.
+// returns 1 if the frame was sent, 0 if hash is the same as the last frame's and it was skipped
+static int ws_stream(wsFetch fetch, const wsFrame * f, int numLEDs, unsigned int hash) {
+    int led = 0; // which WS2812B is being sent
+    int bit = 23; // which of its 24 color bits
+    unsigned int word; // color bits of this LED
+    unsigned int next = 0; // color bits of the next LED
+    unsigned short t = 0; // Timer2 time of the next edge
+    unsigned int now;
+    unsigned int ie = IEC0bits.T4IE;
+
+    if (numLEDs <= 0) {
+        return 0;
+    }
+    hash = ws_hash(hash, &fetch, sizeof(fetch)); // same bytes in another format is another frame
+    now = _CP0_GET_COUNT();
+    if (ws_sent_valid && hash == ws_sent_hash && numLEDs == ws_sent_leds
+            && now - ws_sent_time < ws_refresh_ticks) {
+        return 0; // nothing changed, the LEDs already show it
+    }
+    ws_sent_hash = hash;
+    ws_sent_leds = numLEDs;
+    ws_sent_time = now;
+    ws_sent_valid = 1;
+    word = fetch(f, 0);
+
+    // an interrupt in the middle of a high would make a 0 look like a 1. The CTMU engine's
+    // Timer4 interrupt waits until the frame is on the wire, 30uS per LED, it copes with
+    // being late (see adc.c). The ADC scan and stream interrupts stay on so their buffers
+    // don't overrun on a long strip, see ws2812b.h
+    IEC0bits.T4IE = 0;
+
+    // start the timer, then turn on the pin for the first high/low. The other way round the
+    // first high is long by the time the TMR2 write takes, a 0 could be read as a 1
+    TMR2 = 0;
+    LATBbits.LATB6 = 1;
+    while (1) {
+        // if the bit is a 1 the high is longer, if it is a 0 the low is longer
+        if ((word >> bit) & 1) {
+            t += T1HTIME;
+            if (bit == 23 && led + 1 < numLEDs) {
+                next = fetch(f, led + 1); // plenty of time while the pin is high
+            }
+            WAIT_TMR2(t);
+            LATBINV = 0b1000000; // invert B6
+            t += BITTIME - T1HTIME;
+        } else {
+            t += T0HTIME;
+            WAIT_TMR2(t);
+            LATBINV = 0b1000000; // invert B6
+            t += BITTIME - T0HTIME;
+            if (bit == 23 && led + 1 < numLEDs) {
+                next = fetch(f, led + 1); // plenty of time while the pin is low
             }
         }
-        // do it again for green
-//        c;
-        for (j = 7; j >= 0; j--) {
-            // if the bit is a 1
-            if (c[i].g>>j & 1 == 1) {
-                // the high is longer
-                delay_times[nB] = delay_times[nB - 1] + HIGHTIME;
-                nB++;
-                delay_times[nB] = delay_times[nB - 1] + LOWTIME;
-                nB++;
-            } 
-            // if the bit is a 0
-            else {
-                // the low is longer
-                delay_times[nB] = delay_times[nB - 1] + LOWTIME;
-                nB++;
-                delay_times[nB] = delay_times[nB - 1] + HIGHTIME;
-                nB++;
+        if (bit == 0) {
+            led++;
+            if (led == numLEDs) {
+                break; // the pin is already low after the last bit
             }
+            word = next;
+            bit = 23;
+        } else {
+            bit--;
         }
-		// do it again for blue        
-        for (j = 7; j >= 0; j--) {
-            // if the bit is a 1
-            if (c[i].b>>j & 1 == 1) {
-                // the high is longer
-                delay_times[nB] = delay_times[nB - 1] + HIGHTIME;
-                nB++;
-                delay_times[nB] = delay_times[nB - 1] + LOWTIME;
-                nB++;
-            } 
-            // if the bit is a 0
-            else {
-                // the low is longer
-                delay_times[nB] = delay_times[nB - 1] + LOWTIME;
-                nB++;
-                delay_times[nB] = delay_times[nB - 1] + HIGHTIME;
-                nB++;
+        WAIT_TMR2(t);
+        LATBINV = 0b1000000; // invert B6, start of the next bit
+    }
+    LATBbits.LATB6 = 0;
+    IEC0bits.T4IE = ie;
+    TMR2 = 0;
+    while(TMR2 < WS2812B_RESET_TICKS){} // reset condition
+    return 1;
+}
+
+// 3 bytes per LED
+int ws2812b_setColor(wsColor * c, int numLEDs) {
+    wsFrame f = {c, 0};
+    return ws_stream(ws_fetchColor, &f, numLEDs, ws_hash(2166136261u, c, numLEDs * sizeof(wsColor)));
+}
+
+// 2 bytes per LED, rrrrrggggggbbbbb
+int ws2812b_setColor565(const unsigned short * px, int numLEDs) {
+    wsFrame f = {px, 0};
+    return ws_stream(ws_fetch565, &f, numLEDs, ws_hash(2166136261u, px, numLEDs * 2));
+}
+
+// 1 byte per LED, an index into a 256 color palette
+int ws2812b_setColorPal8(const unsigned char * px, const wsColor * palette, int numLEDs) {
+    wsFrame f = {px, palette};
+    unsigned int hash;
+    hash = ws_hash(2166136261u, px, numLEDs);
+    hash = ws_hash(hash, palette, 256 * sizeof(wsColor));
+    return ws_stream(ws_fetchPal8, &f, numLEDs, hash);
+}
+
+// half a byte per LED, an index into a 16 color palette
+int ws2812b_setColorPal4(const unsigned char * px, const wsColor * palette, int numLEDs) {
+    wsFrame f = {px, palette};
+    unsigned int hash;
+    hash = ws_hash(2166136261u, px, (numLEDs + 1) / 2);
+    hash = ws_hash(hash, palette, 16 * sizeof(wsColor));
+    return ws_stream(ws_fetchPal4, &f, numLEDs, hash);
+}
+
+// SPI output mode
+// Every color bit becomes a 4 bit SPI symbol at 3.43MHz (292ns per SPI bit):
+// 0 -> 1000 (0.29uS high, 0.88uS low), 1 -> 1100 (0.58uS high, 0.58uS low).
+// 3 bit symbols at 2.4MHz would save RAM, but their 0.42uS T1L is under the datasheet's 0.45uS.
+// DMA feeds SPI1BUF, so the CPU is free during the frame and interrupts can't break the timing.
+// SDO1 is on B6 instead of the LATB6 pin of the bit banged mode, SCK1 (B14) toggles but isn't used.
+// test/test_spi.c decodes the stream on the PC and checks it against the colors.
+
+#define WS2812B_SPI_BRG 6 // 48000000/(2*(6+1)) = 3.43MHz
+#define WS2812B_SPI_RESET_BYTES 24 // 24*8 SPI bits low = 56uS, the reset condition
+#define WS_SPI_NS(bits) ((bits) * 2 * (WS2812B_SPI_BRG + 1) * 1000 / 48)
+#if WS_SPI_NS(1) < 350 - 150 || WS_SPI_NS(1) > 350 + 150
+#error "the SPI bit is outside the T0H window"
+#endif
+#if WS_SPI_NS(3) < 800 - 150 || WS_SPI_NS(3) > 800 + 150
+#error "3 SPI bits are outside the T0L window"
+#endif
+#if WS_SPI_NS(2) < 700 - 150 || WS_SPI_NS(2) > 600 + 150
+#error "2 SPI bits are outside the T1H or T1L window"
+#endif
+#if WS_SPI_NS(WS2812B_SPI_RESET_BYTES * 8) < WS2812B_RESET_US * 1000
+#error "WS2812B_SPI_RESET_BYTES is shorter than the reset"
+#endif
+#define WS2812B_SPI_BUFFER (WS2812B_SPI_BYTES_PER_LED * WS2812B_MAX_LEDS + WS2812B_SPI_RESET_BYTES)
+
+// 4 color bits -> 16 SPI bits, MSB first
+static const unsigned short ws_spi_nibble[16] = {
+    0x8888, 0x888C, 0x88C8, 0x88CC, 0x8C88, 0x8C8C, 0x8CC8, 0x8CCC,
+    0xC888, 0xC88C, 0xC8C8, 0xC8CC, 0xCC88, 0xCC8C, 0xCCC8, 0xCCCC
+};
+
+// two buffers so the next frame can be encoded while the last one is still going out
+unsigned char ws_spi_buffer[2][WS2812B_SPI_BUFFER];
+int ws_spi_next = 0; // which buffer to encode into next
+
+// setup SPI1 at 3.43MHz with SDO1 on B6, and DMA channel 0 to feed it
+void ws2812b_spi_setup() {
+    RPB6Rbits.RPB6R = 0b0011; // SDO1 on B6
+
+    SPI1CON = 0; // turn off the spi module and reset it
+    SPI1BUF; // clear the rx buffer by reading from it
+    SPI1BRG = WS2812B_SPI_BRG;
+    SPI1STATbits.SPIROV = 0; // clear the overflow bit
+    SPI1CONbits.MSTEN = 1; // master operation
+    SPI1CONbits.DISSDI = 1; // no SDI pin needed
+    SPI1CONbits.ENHBUF = 1; // use the 16 byte fifo
+    SPI1CONbits.STXISEL = 0b11; // tx interrupt (DMA request) while the fifo is not full
+    SPI1CONbits.ON = 1; // turn on spi, SDO idles low
+
+    DMACONbits.ON = 1; // turn on the DMA controller
+    DCH0CON = 0;
+    DCH0ECON = 0;
+    DCH0ECONbits.CHSIRQ = _SPI1_TX_IRQ; // one byte every time SPI1 has room
+    DCH0ECONbits.SIRQEN = 1;
+    DCH0DSA = KVA_TO_PA(&SPI1BUF); // always write to SPI1BUF
+    DCH0DSIZ = 1;
+    DCH0CSIZ = 1; // one byte per request
+    DCH0CONbits.CHPRI = 3; // highest priority
+}
+
+// turn the colors into the SPI bit stream, 12 bytes per LED followed by the reset bytes
+// returns the number of bytes to send, or WS2812B_TOO_MANY if they don't fit in the buffer
+int ws2812b_spi_encode(wsColor * c, int numLEDs, unsigned char * buf) {
+    int i;
+    int k;
+    unsigned char * p = buf;
+    unsigned char color[3];
+    unsigned int sym;
+    if (numLEDs > WS2812B_MAX_LEDS) {
+        return WS2812B_TOO_MANY;
+    }
+    for (i = 0; i < numLEDs; i++) {
+        // same color order as ws2812b_setColor()
+        color[0] = c[i].r;
+        color[1] = c[i].g;
+        color[2] = c[i].b;
+        for (k = 0; k < 3; k++) {
+            sym = (ws_spi_nibble[color[k] >> 4] << 16) | ws_spi_nibble[color[k] & 0xF];
+            *p++ = sym >> 24;
+            *p++ = sym >> 16;
+            *p++ = sym >> 8;
+            *p++ = sym;
+        }
+    }
+    for (k = 0; k < WS2812B_SPI_RESET_BYTES; k++) {
+        *p++ = 0;
+    }
+    return p - buf;
+}
+
+// 1 while a frame is still being sent
+int ws2812b_spi_busy() {
+    return DCH0CONbits.CHEN || !SPI1STATbits.SRMT;
+}
+
+// encode the colors, wait for the last frame to finish, then let the DMA send it
+// returns 1, or WS2812B_TOO_MANY and sends nothing
+int ws2812b_spi_setColor(wsColor * c, int numLEDs) {
+    unsigned char * buf = ws_spi_buffer[ws_spi_next];
+    int len = ws2812b_spi_encode(c, numLEDs, buf);
+    if (len == WS2812B_TOO_MANY) {
+        return WS2812B_TOO_MANY;
+    }
+    while (ws2812b_spi_busy()) {
+    }
+    DCH0SSA = KVA_TO_PA(buf);
+    DCH0SSIZ = len;
+    DCH0INTCLR = 0xFF; // clear the channel event flags
+    DCH0CONbits.CHEN = 1; // go, the SPI fifo is empty so the first request is already pending
+    ws_spi_next = !ws_spi_next;
+    return 1;
+}
+
+// Output compare mode
+// OC4 on B6 toggles the pin on every Timer2 compare match. After every match DMA channel 1
+// loads the next edge time into OC4R from a table built beforehand, so the edges come from
+// the hardware instead of the polling loop and the CPU is free while the frame goes out.
+// The DMA has to reload OC4R within T0HTIME (0.40uS) of a match, which it does with no other
+// DMA channel competing for the bus.
+// The table ends with a parking time half a Timer2 wrap after the last fall. The DMA loads it
+// on the last fall, and its block done interrupt stops OC4 and Timer2 before it can match, so
+// B6 stays low until the next frame. The reset time is counted from there.
+
+#define WS2812B_OC_EDGES (2 * 24 * WS2812B_MAX_LEDS + 1) // a rise and a fall per color bit, and the parking time
+#define WS2812B_OC_LEAD 100 // Timer2 ticks before the first edge
+#define WS2812B_OC_PARK 32768 // Timer2 ticks from the last fall to the parking time, 680uS
+
+unsigned short ws_oc_edges[WS2812B_OC_EDGES]; // Timer2 time of every edge
+volatile int ws_oc_sending = 0; // 1 from the start of a frame until the ISR stopped OC4
+volatile unsigned int ws_oc_done = 0; // core timer when the last frame ended
+
+// setup Timer2 for 48MHz, OC4 in toggle mode on B6, and DMA channel 1 to reload OC4R
+void ws2812b_oc_setup() {
+    T2CONbits.TCKPS = 0; // Timer2 prescaler N=1 (1:1)
+    PR2 = 65535; // maximum period, the edge times wrap with TMR2
+    TMR2 = 0; // initialize Timer2 to 0
+
+    TRISBbits.TRISB6 = 0; // low while OC4 is off too
+    LATBbits.LATB6 = 0;
+    RPB6Rbits.RPB6R = 0b0101; // OC4 on B6
+    OC4CON = 0;
+    OC4CONbits.OCTSEL = 0; // use Timer2
+    OC4CONbits.OCM = 0b011; // toggle the pin on every compare match, starts low
+
+    DMACONbits.ON = 1; // turn on the DMA controller
+    DCH1CON = 0;
+    DCH1ECON = 0;
+    DCH1ECONbits.CHSIRQ = _OUTPUT_COMPARE_4_IRQ; // next edge after every match
+    DCH1ECONbits.SIRQEN = 1;
+    DCH1DSA = KVA_TO_PA(&OC4R); // always write to OC4R
+    DCH1DSIZ = 2;
+    DCH1CSIZ = 2; // one edge time per match
+    DCH1CONbits.CHPRI = 3; // highest priority
+    DCH1INTCLR = 0xFF; // clear the channel event flags
+    DCH1INTbits.CHBCIE = 1; // interrupt when the parking time is loaded, at the last fall
+
+    ws_oc_sending = 0;
+    ws_oc_done = _CP0_GET_COUNT();
+    IPC10bits.DMA1IP = 3; // same as IPL3SOFT in the ISR
+    IPC10bits.DMA1IS = 0;
+    IFS1bits.DMA1IF = 0;
+    IEC1bits.DMA1IE = 1; // needs INTCONbits.MVEC and interrupts on, like main does
+}
+
+// the last fall just happened: stop OC4 and Timer2 before the parking time can toggle B6
+void __ISR(_DMA_1_VECTOR, IPL3SOFT) ws_oc_isr(void) {
+    OC4CONbits.ON = 0; // B6 low
+    T2CONbits.ON = 0;
+    ws_oc_done = _CP0_GET_COUNT(); // the reset starts now
+    ws_oc_sending = 0;
+    DCH1INTCLR = 0xFF;
+    IFS1bits.DMA1IF = 0;
+}
+
+// 1 until the last fall of the frame
+int ws2812b_oc_busy() {
+    return ws_oc_sending;
+}
+
+// turn the colors into the edge table, ending with the parking time
+// returns the number of entries, or WS2812B_TOO_MANY if they don't fit in the table
+// don't call it while ws2812b_oc_busy()
+int ws2812b_oc_encode(wsColor * c, int numLEDs) {
+    int i;
+    int j;
+    int n = 0; // number of edges
+    unsigned int word;
+    unsigned short t = WS2812B_OC_LEAD;
+
+    if (numLEDs > WS2812B_MAX_LEDS) {
+        return WS2812B_TOO_MANY;
+    }
+    for (i = 0; i < numLEDs; i++) {
+        word = WS_PACK(c[i]);
+        for (j = 23; j >= 0; j--) {
+            ws_oc_edges[n++] = t; // rise at the start of the bit
+            t += ((word >> j) & 1) ? T1HTIME : T0HTIME;
+            ws_oc_edges[n++] = t; // fall
+            t += ((word >> j) & 1) ? BITTIME - T1HTIME : BITTIME - T0HTIME;
+        }
+    }
+    if (n > 0) {
+        ws_oc_edges[n] = ws_oc_edges[n - 1] + WS2812B_OC_PARK; // loaded at the last fall, never reached
+        n++;
+    }
+    return n;
+}
+
+// build the edge table from the colors and let OC4 + DMA send it
+// returns 1, 0 for no LEDs, or WS2812B_TOO_MANY and sends nothing
+int ws2812b_oc_setColor(wsColor * c, int numLEDs) {
+    int n;
+
+    if (numLEDs > WS2812B_MAX_LEDS) {
+        return WS2812B_TOO_MANY; // before waiting, the frame on the wire keeps its table
+    }
+    if (numLEDs <= 0) {
+        return 0;
+    }
+    // the table is in use until the last frame is done, then hold low to reset
+    while (ws2812b_oc_busy()) {
+    }
+    while (_CP0_GET_COUNT() - ws_oc_done < WS2812B_RESET_US * 24) { // core timer is 24MHz
+    }
+    n = ws2812b_oc_encode(c, numLEDs);
+
+    ws_oc_sending = 1;
+    T2CONbits.ON = 0;
+    OC4CONbits.ON = 0; // B6 low
+    TMR2 = 0;
+    OC4R = ws_oc_edges[0]; // first edge, the DMA loads the rest
+    IFS0bits.OC4IF = 0;
+    DCH1SSA = KVA_TO_PA(&ws_oc_edges[1]);
+    DCH1SSIZ = 2 * (n - 1);
+    DCH1INTCLR = 0xFF; // clear the channel event flags
+    DCH1CONbits.CHEN = 1;
+    OC4CONbits.ON = 1;
+    T2CONbits.ON = 1; // go
+    return 1;
+}
+
+// Parallel output mode
+// Up to 8 strips on neighboring LATB pins are sent at the same time. The colors are
+// transposed beforehand into one byte per color bit with bit s for strip s (bit slices),
+// so every bit period is just: all strips high, the strips sending a 0 low at T0HTIME,
+// all strips low at T1HTIME. A frame of N strips takes as long as a frame of one strip.
+// Pick pins that are free, B8 and B9 are the I2C1 of the OLED.
+
+#define WS2812B_PAR_SLICES (WS2812B_PAR_BYTES_PER_LED * WS2812B_MAX_LEDS)
+
+unsigned char ws_par_slices[WS2812B_PAR_SLICES]; // one byte per color bit, MSB first
+unsigned int ws_par_shift = 0; // LATB pin of strip 0
+unsigned int ws_par_mask = 0; // LATB pins of all the strips
+int ws_par_strips = 0;
+
+// setup Timer2 for 48MHz and strips on LATB pins firstPin to firstPin+numStrips-1
+void ws2812b_par_setup(int firstPin, int numStrips) {
+    if (numStrips > WS2812B_PAR_MAX_STRIPS) {
+        numStrips = WS2812B_PAR_MAX_STRIPS;
+    }
+    if (firstPin + numStrips > 16) {
+        numStrips = 16 - firstPin;
+    }
+    if (firstPin < 0 || numStrips <= 0) {
+        ws_par_strips = 0;
+        ws_par_mask = 0;
+        return;
+    }
+    ws_par_strips = numStrips;
+    ws_par_shift = firstPin;
+    ws_par_mask = ((1 << numStrips) - 1) << firstPin;
+
+    T2CONbits.TCKPS = 0; // Timer2 prescaler N=1 (1:1)
+    PR2 = 65535; // maximum period
+    TMR2 = 0; // initialize Timer2 to 0
+    T2CONbits.ON = 1; // turn on Timer2
+
+    // initialize output pins as digital and off
+    ANSELBCLR = ws_par_mask;
+    TRISBCLR = ws_par_mask;
+    LATBCLR = ws_par_mask;
+}
+
+// 8x8 bit transpose of one color byte of every strip, from Hacker's Delight (transpose8)
+// in[s] is the byte of strip s, out[k] gets bit 7-k of every strip with strip s at bit s
+static void ws_par_transpose(const unsigned char * in, unsigned char * out) {
+    unsigned int x, y, t;
+    // rows in reverse so strip s ends up at bit s
+    x = (in[7] << 24) | (in[6] << 16) | (in[5] << 8) | in[4];
+    y = (in[3] << 24) | (in[2] << 16) | (in[1] << 8) | in[0];
+
+    t = (x ^ (x >> 7)) & 0x00AA00AA;
+    x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AA;
+    y = y ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC;
+    x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCC;
+    y = y ^ t ^ (t << 14);
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+    x = t;
+
+    out[0] = x >> 24;
+    out[1] = x >> 16;
+    out[2] = x >> 8;
+    out[3] = x;
+    out[4] = y >> 24;
+    out[5] = y >> 16;
+    out[6] = y >> 8;
+    out[7] = y;
+}
+
+// turn the colors of every strip into bit slices, strips[s] is numLEDs colors or NULL for off
+// returns the number of slices, or WS2812B_TOO_MANY if they don't fit
+int ws2812b_par_encode(wsColor ** strips, int numLEDs) {
+    int i, s;
+    unsigned char r[8], g[8], b[8];
+    unsigned char * out = ws_par_slices;
+
+    if (numLEDs > WS2812B_MAX_LEDS) {
+        return WS2812B_TOO_MANY;
+    }
+    for (s = 0; s < 8; s++) {
+        r[s] = 0;
+        g[s] = 0;
+        b[s] = 0;
+    }
+    for (i = 0; i < numLEDs; i++) {
+        for (s = 0; s < ws_par_strips; s++) {
+            if (strips[s]) {
+                r[s] = strips[s][i].r;
+                g[s] = strips[s][i].g;
+                b[s] = strips[s][i].b;
             }
-        }         
+        }
+        // same order as WS_PACK
+        ws_par_transpose(r, out);
+        ws_par_transpose(g, out + 8);
+        ws_par_transpose(b, out + 16);
+        out += WS2812B_PAR_BYTES_PER_LED;
     }
+    return out - ws_par_slices;
+}
 
-    // turn on the pin for the first high/low
-    LATBbits.LATB6 = 1;
+// encode, then send every strip at once, numLEDs on each
+// returns 1, 0 for no LEDs or strips, or WS2812B_TOO_MANY and sends nothing
+int ws2812b_par_setColor(wsColor ** strips, int numLEDs) {
+    unsigned char * slice = ws_par_slices;
+    unsigned char * end;
+    unsigned int zeros; // strips sending a 0 this bit
+    unsigned short t = 0;
+    unsigned int ie = IEC0bits.T4IE;
+    int n;
+
+    if (ws_par_strips == 0 || numLEDs <= 0) {
+        return 0;
+    }
+    n = ws2812b_par_encode(strips, numLEDs);
+    if (n == WS2812B_TOO_MANY) {
+        return WS2812B_TOO_MANY;
+    }
+    end = ws_par_slices + n;
+    zeros = ~(*slice << ws_par_shift) & ws_par_mask;
+
+    IEC0bits.T4IE = 0; // no CTMU interrupt in the middle of a bit, like ws_stream
     TMR2 = 0; // start the timer
-    for (i = 1; i < numBits; i++) {
-        while (TMR2 < delay_times[i]) {
+    while (1) {
+        LATBSET = ws_par_mask; // start of the bit, every strip high
+        t += T0HTIME;
+        WAIT_TMR2(t);
+        LATBCLR = zeros; // the 0 bits end here
+        slice++;
+        if (slice != end) {
+            zeros = ~(*slice << ws_par_shift) & ws_par_mask; // work out the next bit meanwhile
+        }
+        t += T1HTIME - T0HTIME;
+        WAIT_TMR2(t);
+        LATBCLR = ws_par_mask; // the 1 bits end here
+        if (slice == end) {
+            break;
         }
-        LATBINV = 0b1000000; // invert B6
+        t += BITTIME - T1HTIME;
+        WAIT_TMR2(t);
     }
-    LATBbits.LATB6 = 0;
+    IEC0bits.T4IE = ie;
     TMR2 = 0;
-    while(TMR2 < 2400){} // wait 50uS, reset condition
+    while(TMR2 < WS2812B_RESET_TICKS){} // reset condition
+    return 1;
+}
+
+// Output stage: gamma, global brightness and temporal dithering
+// Colors are made 16 bit (gamma LUT), scaled by the global brightness, and the part below
+// 8 bits is carried to the next frame per LED and color (error diffusion), so dim levels
+// average out to the right brightness over a few frames instead of being truncated.
+
+// (i/255)^2.2 * 65535
+static const unsigned short ws_gamma[256] = {
+        0,     0,     2,     4,     7,    11,    17,    24,
+       32,    42,    53,    65,    79,    94,   111,   129,
+      148,   169,   192,   216,   242,   270,   299,   330,
+      362,   396,   432,   469,   508,   549,   591,   635,
+      681,   729,   779,   830,   883,   938,   995,  1053,
+     1113,  1175,  1239,  1305,  1373,  1443,  1514,  1587,
+     1663,  1740,  1819,  1900,  1983,  2068,  2155,  2243,
+     2334,  2427,  2521,  2618,  2717,  2817,  2920,  3024,
+     3131,  3240,  3350,  3463,  3578,  3694,  3813,  3934,
+     4057,  4182,  4309,  4438,  4570,  4703,  4838,  4976,
+     5115,  5257,  5401,  5547,  5695,  5845,  5998,  6152,
+     6309,  6468,  6629,  6792,  6957,  7124,  7294,  7466,
+     7640,  7816,  7994,  8175,  8358,  8543,  8730,  8919,
+     9111,  9305,  9501,  9699,  9900, 10102, 10307, 10515,
+    10724, 10936, 11150, 11366, 11585, 11806, 12029, 12254,
+    12482, 12712, 12944, 13179, 13416, 13655, 13896, 14140,
+    14386, 14635, 14885, 15138, 15394, 15652, 15912, 16174,
+    16439, 16706, 16975, 17247, 17521, 17798, 18077, 18358,
+    18642, 18928, 19216, 19507, 19800, 20095, 20393, 20694,
+    20996, 21301, 21609, 21919, 22231, 22546, 22863, 23182,
+    23504, 23829, 24156, 24485, 24817, 25151, 25487, 25826,
+    26168, 26512, 26858, 27207, 27558, 27912, 28268, 28627,
+    28988, 29351, 29717, 30086, 30457, 30830, 31206, 31585,
+    31966, 32349, 32735, 33124, 33514, 33908, 34304, 34702,
+    35103, 35507, 35913, 36321, 36732, 37146, 37562, 37981,
+    38402, 38825, 39252, 39680, 40112, 40546, 40982, 41421,
+    41862, 42306, 42753, 43202, 43654, 44108, 44565, 45025,
+    45487, 45951, 46418, 46888, 47360, 47835, 48313, 48793,
+    49275, 49761, 50249, 50739, 51232, 51728, 52226, 52727,
+    53230, 53736, 54245, 54756, 55270, 55787, 56306, 56828,
+    57352, 57879, 58409, 58941, 59476, 60014, 60554, 61097,
+    61642, 62190, 62741, 63295, 63851, 64410, 64971, 65535
+};
+
+unsigned short ws_brightness = 256; // global brightness, 256 is full
+wsColor ws_out[WS2812B_MAX_LEDS]; // 8 bit colors sent this frame
+unsigned char ws_err[WS2812B_MAX_LEDS][3]; // what was left below 8 bits last frame
+
+// global brightness 0 to 256, applied after the gamma
+void ws2812b_setBrightness(unsigned short brightness) {
+    if (brightness > 256) {
+        brightness = 256;
+    }
+    ws_brightness = brightness;
+}
+
+// 16 bit linear color -> 8 bit, adding last frame's leftover of this LED and color
+static unsigned char ws_dither(unsigned short v, unsigned char * err) {
+    unsigned int x = ((v * ws_brightness) >> 8) + *err;
+    *err = x & 0xFF;
+    x = x >> 8;
+    return x > 255 ? 255 : x;
+}
+
+// send 16 bit linear colors through brightness and dithering, returns 1 if sent, see ws2812b.h
+int ws2812b_show16(wsColor16 * c, int numLEDs) {
+    int i;
+    if (numLEDs > WS2812B_MAX_LEDS) {
+        return WS2812B_TOO_MANY; // no dither state for the rest
+    }
+    for (i = 0; i < numLEDs; i++) {
+        ws_out[i].r = ws_dither(c[i].r, &ws_err[i][0]);
+        ws_out[i].g = ws_dither(c[i].g, &ws_err[i][1]);
+        ws_out[i].b = ws_dither(c[i].b, &ws_err[i][2]);
+    }
+    return ws2812b_setColor(ws_out, numLEDs);
+}
+
+// send 8 bit colors through the gamma LUT, brightness and dithering, returns 1 if sent, see ws2812b.h
+int ws2812b_show(wsColor * c, int numLEDs) {
+    int i;
+    if (numLEDs > WS2812B_MAX_LEDS) {
+        return WS2812B_TOO_MANY; // no dither state for the rest
+    }
+    for (i = 0; i < numLEDs; i++) {
+        ws_out[i].r = ws_dither(ws_gamma[c[i].r], &ws_err[i][0]);
+        ws_out[i].g = ws_dither(ws_gamma[c[i].g], &ws_err[i][1]);
+        ws_out[i].b = ws_dither(ws_gamma[c[i].b], &ws_err[i][2]);
+    }
+    return ws2812b_setColor(ws_out, numLEDs);
 }
 
 // adapted from https://forum.arduino.cc/index.php?topic=8498.0
@@ -180,4 +785,65 @@ wsColor HSBtoRGB(float hue, float sat, float brightness) {
     c.g = igreen;
     c.b = iblue;
     return c;
-}
\ No newline at end of file
+}
+
+// a*b/255 rounded to the nearest integer, without a division
+#define MUL255(a, b) ((((a)*(b) + 128) + ((((a)*(b) + 128)) >> 8)) >> 8)
+
+// integer version of HSBtoRGB(), no float math
+// hue is 0 to HSB_HUE_MAX-1, 256 steps for every 60 degrees of the color wheel
+// sat and brightness are 0 to 255
+wsColor HSBtoRGB_fixed(unsigned int hue, unsigned char sat, unsigned char brightness) {
+    wsColor c;
+    unsigned int slice = hue >> 8; // which 60 degrees
+    unsigned int frac = hue & 0xFF; // how far into it, out of 256
+    unsigned char aa = MUL255(brightness, 255 - sat);
+    unsigned char bb = MUL255(brightness, 255 - ((sat * frac) >> 8));
+    unsigned char cc = MUL255(brightness, 255 - ((sat * (256 - frac)) >> 8));
+
+    switch (slice) {
+        case 0:
+            c.r = brightness; c.g = cc; c.b = aa;
+            break;
+        case 1:
+            c.r = bb; c.g = brightness; c.b = aa;
+            break;
+        case 2:
+            c.r = aa; c.g = brightness; c.b = cc;
+            break;
+        case 3:
+            c.r = aa; c.g = bb; c.b = brightness;
+            break;
+        case 4:
+            c.r = cc; c.g = aa; c.b = brightness;
+            break;
+        case 5:
+            c.r = brightness; c.g = aa; c.b = bb;
+            break;
+        default:
+            c.r = 0; c.g = 0; c.b = 0;
+            break;
+    }
+    return c;
+}
+
+// fill the whole color array with a rainbow, the hues evenly spaced around the wheel
+// starting from hue (0 to HSB_HUE_MAX-1) at the first LED
+void HSBtoRGB_rainbow(wsColor * c, int numLEDs, unsigned int hue, unsigned char sat, unsigned char brightness) {
+    int i;
+    unsigned int step;
+    if (numLEDs <= 0) {
+        return;
+    }
+    step = HSB_HUE_MAX / numLEDs;
+    while (hue >= HSB_HUE_MAX) {
+        hue -= HSB_HUE_MAX;
+    }
+    for (i = 0; i < numLEDs; i++) {
+        c[i] = HSBtoRGB_fixed(hue, sat, brightness);
+        hue += step;
+        if (hue >= HSB_HUE_MAX) {
+            hue -= HSB_HUE_MAX;
+        }
+    }
+}
@@ -0,0 +1,176 @@
+// 4 level grayscale on the ssd1306 by frame modulation, see gray.h
+
+#include "gray.h"
+#include <string.h> // for memset
+#include "ssd1306.h"
+#include "font.h"
+
+unsigned char gray_plane0[512]; // low bit of every pixel, same layout as ssd1306_buffer
+unsigned char gray_plane1[512]; // high bit of every pixel
+
+// column windows per page, lo > hi means empty
+unsigned char gray_lo[4], gray_hi[4]; // columns with level 1 or 2 pixels, the planes differ here
+unsigned char gray_changed_lo[4], gray_changed_hi[4]; // columns drawn since the current cycle started
+unsigned char gray_cycle_lo[4], gray_cycle_hi[4]; // columns drawn that are sent during this cycle
+
+int gray_current_mode = GRAY_MODE_4LEVEL;
+int gray_phase = 0; // 0 sends the high plane for 2 panel frames, 1 the low plane for 1
+int gray_slow = 0; // slow subframes in a row
+unsigned int gray_period; // core timer ticks per panel frame, one subframe
+unsigned int gray_next_push; // core timer when the next send is due
+unsigned int gray_push_ticks; // core timer ticks the last subframe took
+
+// empty every window in lo/hi
+static void window_clear(unsigned char *lo, unsigned char *hi) {
+    memset(lo, 128, 4);
+    memset(hi, 0, 4);
+}
+
+// grow the window of a page to include column x
+static void window_grow(unsigned char *lo, unsigned char *hi, unsigned char page, unsigned char x) {
+    if (x < lo[page]) {
+        lo[page] = x;
+    }
+    if (x > hi[page]) {
+        hi[page] = x;
+    }
+}
+
+void gray_setup() {
+    // one subframe per panel refresh: slow the panel down to GRAY_SUBFRAME_HZ or below and
+    // pace the subframes by the same period, so a subframe is never split over two refreshes
+    ssd1306_command(SSD1306_SETDISPLAYCLOCKDIV);
+    ssd1306_command(0x80 | (GRAY_CLOCK_DIV - 1)); // default oscillator, divide ratio GRAY_CLOCK_DIV
+    gray_period = 24000000 / GRAY_PANEL_HZ * GRAY_CLOCK_DIV; // core timer runs at 24MHz
+
+    gray_current_mode = GRAY_MODE_4LEVEL;
+    gray_phase = 0;
+    gray_slow = 0;
+    gray_next_push = _CP0_GET_COUNT();
+    gray_clear();
+}
+
+// every pixel to level 0, the next cycle sends the whole screen
+void gray_clear() {
+    memset(gray_plane0, 0, 512);
+    memset(gray_plane1, 0, 512);
+    window_clear(gray_lo, gray_hi);
+    window_clear(gray_cycle_lo, gray_cycle_hi);
+    memset(gray_changed_lo, 0, 4);
+    memset(gray_changed_hi, 127, 4);
+}
+
+void gray_drawPixel(unsigned char x, unsigned char y, unsigned char level) {
+    if ((x >= 128) || (y >= 32)) {
+        return;
+    }
+    unsigned char page = y / 8;
+    unsigned short i = x + page*128;
+    unsigned char bit = 1 << (y & 7);
+    unsigned char p0 = (level & 1) ? (gray_plane0[i] | bit) : (gray_plane0[i] & ~bit);
+    unsigned char p1 = (level & 2) ? (gray_plane1[i] | bit) : (gray_plane1[i] & ~bit);
+    if ((p0 != gray_plane0[i]) || (p1 != gray_plane1[i])) {
+        gray_plane0[i] = p0;
+        gray_plane1[i] = p1;
+        window_grow(gray_changed_lo, gray_changed_hi, page, x);
+    }
+    if (p0 != p1) {
+        window_grow(gray_lo, gray_hi, page, x);
+    }
+}
+
+// text in one level, the same 5x8 font and line wrapping as drawMessage()
+void gray_drawMessage(unsigned char x, unsigned char y, char * arr, unsigned char level) {
+    unsigned char code;
+    const unsigned char * glyph;
+    int j, k;
+    while (*arr) {
+        code = (unsigned char) *arr++;
+        glyph = FONT_GLYPHS[code < 128 ? FONT_INDEX[code] : FONT_SLOT_FALLBACK];
+        for (j = 0; j <= 4; j++) {
+            for (k = 0; k <= 7; k++) {
+                gray_drawPixel(x + j, y + k, ((glyph[j] >> k) & 1) ? level : 0);
+            }
+        }
+        x = x + 5;
+        if (x + 5 >= 128) {
+            x = 0;
+            y = y + 8;
+        }
+    }
+}
+
+// drop to 1 bit, only the high plane is shown and only when it changes
+static void gray_fallback() {
+    gray_current_mode = GRAY_MODE_1BPP;
+    ssd1306_command(SSD1306_SETDISPLAYCLOCKDIV);
+    ssd1306_command(0x80); // back to the default panel refresh
+    ssd1306_sendFrame(gray_plane1);
+    window_clear(gray_changed_lo, gray_changed_hi);
+}
+
+void gray_refresh() {
+    unsigned int now = _CP0_GET_COUNT();
+    int page;
+    int hold;
+    unsigned char lo, hi;
+
+    if (gray_current_mode == GRAY_MODE_1BPP) {
+        for (page = 0; page < 4; page++) {
+            if (gray_changed_lo[page] <= gray_changed_hi[page]) {
+                ssd1306_sendWindow(gray_plane1, page, gray_changed_lo[page], gray_changed_hi[page]);
+            }
+        }
+        window_clear(gray_changed_lo, gray_changed_hi);
+        return;
+    }
+
+    if ((int) (now - gray_next_push) < 0) {
+        return; // not time for the next subframe yet
+    }
+    // the high plane stays up for 2 panel frames, the low plane for 1. Counted from when
+    // the send was due rather than from now, so the subframes don't drift against the panel
+    hold = (gray_phase == 0) ? 2 : 1;
+    gray_next_push += hold * gray_period;
+    if ((int) (now - gray_next_push) >= 0) {
+        gray_next_push = now + hold * gray_period; // fell a whole subframe behind, start over
+    }
+
+    // new drawing is sent in both planes during the next whole cycle
+    if (gray_phase == 0) {
+        memcpy(gray_cycle_lo, gray_changed_lo, 4);
+        memcpy(gray_cycle_hi, gray_changed_hi, 4);
+        window_clear(gray_changed_lo, gray_changed_hi);
+    }
+
+    unsigned char * plane = (gray_phase == 1) ? gray_plane0 : gray_plane1;
+    for (page = 0; page < 4; page++) {
+        lo = gray_lo[page] < gray_cycle_lo[page] ? gray_lo[page] : gray_cycle_lo[page];
+        hi = gray_hi[page] > gray_cycle_hi[page] ? gray_hi[page] : gray_cycle_hi[page];
+        if (lo <= hi) {
+            ssd1306_sendWindow(plane, page, lo, hi);
+        }
+    }
+    gray_push_ticks = _CP0_GET_COUNT() - now;
+
+    // the bus can't keep up with the subframe rate, fall back to 1 bit
+    if (gray_push_ticks > hold * gray_period) {
+        gray_slow++;
+        if (gray_slow >= GRAY_SLOW_LIMIT) {
+            gray_fallback();
+            return;
+        }
+    } else {
+        gray_slow = 0;
+    }
+
+    gray_phase = !gray_phase;
+}
+
+int gray_mode() {
+    return gray_current_mode;
+}
+
+unsigned int gray_pushTicks() {
+    return gray_push_ticks;
+}
@@ -9,6 +9,9 @@
 unsigned char ssd1306_write = 0b01111000; // 0111100 i2c address unique address of ssd1306
 unsigned char ssd1306_read = 0b01111001; //   
 unsigned char ssd1306_buffer[512]; // 128x32/8. Every bit is a pixel  
+// dirty column window of each of the 4 pages, lo > hi means the page is clean
+unsigned char ssd1306_dirty_lo[4] = {128, 128, 128, 128};
+unsigned char ssd1306_dirty_hi[4] = {0, 0, 0, 0};
 
 void ssd1306_setup() {
     // give a little delay for the ssd1306 to power up
@@ -51,8 +54,8 @@ void ssd1306_command(unsigned char c) {
     i2c_master_stop();
 }
 
-// update every pixel on the screen
-void ssd1306_update() {
+// send a whole 512 byte frame, in the same layout as ssd1306_buffer
+void ssd1306_sendFrame(unsigned char * frame) {
     ssd1306_command(SSD1306_PAGEADDR);
     ssd1306_command(0);
     ssd1306_command(0xFF);
@@ -61,7 +64,7 @@ void ssd1306_update() {
     ssd1306_command(128 - 1); // Width
 
     unsigned short count = 512; // WIDTH * ((HEIGHT + 7) / 8)
-    unsigned char * ptr = ssd1306_buffer; // first address of the pixel buffer
+    unsigned char * ptr = frame; // first address of the pixel buffer
     i2c_master_start();
     i2c_master_send(ssd1306_write);
     i2c_master_send(0x40); // send pixel data
@@ -72,35 +75,115 @@ void ssd1306_update() {
     i2c_master_stop();
 }
 
+// send columns lo to hi of one page of a 512 byte frame
+void ssd1306_sendWindow(unsigned char * frame, unsigned char page, unsigned char lo, unsigned char hi) {
+    ssd1306_command(SSD1306_PAGEADDR);
+    ssd1306_command(page);
+    ssd1306_command(page);
+    ssd1306_command(SSD1306_COLUMNADDR);
+    ssd1306_command(lo);
+    ssd1306_command(hi);
+
+    unsigned char * ptr = frame + page*128 + lo;
+    unsigned short count = hi - lo + 1;
+    i2c_master_start();
+    i2c_master_send(ssd1306_write);
+    i2c_master_send(0x40); // send pixel data
+    while (count--) {
+        i2c_master_send(*ptr++);
+    }
+    i2c_master_stop();
+}
+
+// update every pixel on the screen
+void ssd1306_update() {
+    ssd1306_sendFrame(ssd1306_buffer);
+    // the whole screen is up to date now
+    int page;
+    for (page = 0; page < 4; page++) {
+        ssd1306_dirty_lo[page] = 128;
+        ssd1306_dirty_hi[page] = 0;
+    }
+}
+
+// only send the columns that changed since the last update, one window per page
+void ssd1306_updateDirty() {
+    int page;
+    for (page = 0; page < 4; page++) {
+        if (ssd1306_dirty_lo[page] > ssd1306_dirty_hi[page]) {
+            continue; // nothing changed on this page
+        }
+        ssd1306_sendWindow(ssd1306_buffer, page, ssd1306_dirty_lo[page], ssd1306_dirty_hi[page]);
+        ssd1306_dirty_lo[page] = 128;
+        ssd1306_dirty_hi[page] = 0;
+    }
+}
+
+// grow the dirty window of a page to include column x
+void ssd1306_markDirty(unsigned char page, unsigned char x) {
+    if (x < ssd1306_dirty_lo[page]) {
+        ssd1306_dirty_lo[page] = x;
+    }
+    if (x > ssd1306_dirty_hi[page]) {
+        ssd1306_dirty_hi[page] = x;
+    }
+}
+
 // set a pixel value. Call update() to push to the display)
 void ssd1306_drawPixel(unsigned char x, unsigned char y, unsigned char color) {//Color = ON or OFF
     if ((x < 0) || (x >= 128) || (y < 0) || (y >= 32)) {
         return;
     }
 
+    unsigned char page = y / 8;
+    unsigned char old = ssd1306_buffer[x + page*128];
+    unsigned char now;
     if (color == 1) {
-        ssd1306_buffer[x + (y / 8)*128] |= (1 << (y & 7));
+        now = old | (1 << (y & 7));
     } else {
-        ssd1306_buffer[x + (y / 8)*128] &= ~(1 << (y & 7));
+        now = old & ~(1 << (y & 7));
+    }
+    if (now != old) {
+        ssd1306_buffer[x + page*128] = now;
+        ssd1306_markDirty(page, x);
     }
 }
 
 // zero every pixel value
 void ssd1306_clear() {
     memset(ssd1306_buffer, 0, 512); // make every bit a 0, memset in string.h
+    // mark the whole screen dirty
+    memset(ssd1306_dirty_lo, 0, 4);
+    memset(ssd1306_dirty_hi, 127, 4);
 }
 
 void drawLetter(unsigned char x, unsigned char y, char character){
     //Takes x and y as the position of the character
-    //Draw a letter with x & y increase gradually
+    //The glyph is already packed as the 5 column bytes of the buffer
+    //Bytes 128-255 aren't in the table, they draw the fallback instead of wrapping onto ascii
+    unsigned char code = (unsigned char) character;
+    const unsigned char *glyph = FONT_GLYPHS[code < 128 ? FONT_INDEX[code] : FONT_SLOT_FALLBACK];
     int j;
     int k;
     int scan_y;
     int color;
+    //On a page boundary every column is exactly one byte of the buffer
+    if ((y & 7) == 0 && y < 32 && x + 4 < 128) {
+        unsigned char page = y / 8;
+        unsigned char * ptr = ssd1306_buffer + page*128 + x;
+        for(j=0; j <= 4; j++){
+            if (ptr[j] != glyph[j]) {
+                ptr[j] = glyph[j];
+                ssd1306_markDirty(page, x + j);
+            }
+        }
+        return;
+    }
+    //Otherwise draw a letter with x & y increase gradually
     for(j=0; j <= 4; j++){
         scan_y = y;
         for(k=0; k <= 7; k++){
-            color = (ASCII[character-0x20][j]>>k) & 1;
+            color = (glyph[j]>>k) & 1;
             ssd1306_drawPixel(x,scan_y,color);
             scan_y = scan_y + 1;
         }
@@ -119,4 +202,46 @@ void drawMessage(unsigned char x, unsigned char y, char *arr){
             y = y + 8;
         }
     }
+}
+
+// a text field remembers what it drew last time, so a new string only
+// redraws the character cells that are different
+void textField_init(textField *f, unsigned char x, unsigned char y, unsigned char width){
+    if (width > TEXTFIELD_MAX) {
+        width = TEXTFIELD_MAX;
+    }
+    f->x = x;
+    f->y = y;
+    f->width = width;
+    textField_invalidate(f);
+}
+
+// forget what is on the screen, the next textField_set() redraws every cell
+void textField_invalidate(textField *f){
+    memset(f->text, 0, TEXTFIELD_MAX);
+}
+
+void textField_set(textField *f, char *arr){
+    int s;
+    int end = 0;
+    unsigned char x = f->x;
+    unsigned char y = f->y;
+    char character;
+    for (s = 0; s < f->width; s++) {
+        // pad with spaces after the end of the string to erase old characters
+        if (!end && arr[s] == 0) {
+            end = 1;
+        }
+        character = end ? ' ' : arr[s];
+        if (character != f->text[s]) {
+            drawLetter(x, y, character);
+            f->text[s] = character;
+        }
+        // same line change rule as drawMessage()
+        x = x + 5;
+        if (x+5 >= 128) {
+            x = 0;
+            y = y + 8;
+        }
+    }
 }
\ No newline at end of file
@@ -28,7 +28,26 @@
 void ssd1306_setup(void);
 void ssd1306_update(void);
 void ssd1306_clear(void);
+void ssd1306_updateDirty(void); // only send the columns changed since the last update
+void ssd1306_sendFrame(unsigned char * frame); // push any 512 byte frame to the screen
+void ssd1306_sendWindow(unsigned char * frame, unsigned char page, unsigned char lo, unsigned char hi);
 void ssd1306_drawPixel(unsigned char x, unsigned char y, unsigned char color);
+void ssd1306_markDirty(unsigned char page, unsigned char x); // column x of a page needs to be sent
+void drawLetter(unsigned char x, unsigned char y, char character);
+void drawMessage(unsigned char x, unsigned char y, char *arr);
+
+// retained text field, keeps the last string so only changed characters are redrawn
+#define TEXTFIELD_MAX 32 // most characters in a field
+typedef struct {
+    unsigned char x;
+    unsigned char y;
+    unsigned char width; // number of characters
+    char text[TEXTFIELD_MAX]; // what is on the screen right now
+} textField;
+
+void textField_init(textField *f, unsigned char x, unsigned char y, unsigned char width);
+void textField_invalidate(textField *f);
+void textField_set(textField *f, char *arr);
 
 /// this should be private
 void ssd1306_command(unsigned char c);//i2c low level function
@@ -0,0 +1,44 @@
+#ifndef GRAY_H__
+#define GRAY_H__
+
+#include <xc.h>
+
+// 4 level grayscale on the 1 bit ssd1306 by frame modulation.
+// Every pixel has 2 bits, kept in two bitplanes with the ssd1306_buffer layout.
+// A cycle is 3 panel frames: the high plane is sent once and shown for two of them, the low
+// plane for the third, so level 0,1,2,3 is lit 0/3, 1/3, 2/3, 3/3 of the time.
+// The panel refresh is divided down to GRAY_SUBFRAME_HZ or below with SETDISPLAYCLOCKDIV and
+// the subframes are paced by that same period. The ssd1306 has no frame sync on I2C, so the
+// two only stay lined up as well as GRAY_PANEL_HZ matches the panel's oscillator.
+//
+// Throughput needed: 2 sends per 3 panel frames, the low plane one in a single frame.
+// Estimated from the bus rate, not measured: a full 512 byte frame is about 520 bytes * 9 bits,
+// 235kHz (I2C1BRG = 100) -> ~20ms -> ~50 subframes/s, 400kHz -> ~12ms -> ~85 subframes/s.
+// GRAY_DEMO in rtcc.c shows the measured push time, gray_pushTicks(), on the screen.
+// That is too slow for a whole screen of gray, so after the first full frame only the
+// columns where the two planes differ (the gray window) are sent each subframe.
+// If a subframe push still takes longer than the frames it is held for GRAY_SLOW_LIMIT times
+// in a row, the driver falls back to 1 bit mode (level 2 and 3 on, 0 and 1 off).
+
+#define GRAY_SUBFRAME_HZ 90 // highest panel refresh wanted, what the bus can keep up with
+#define GRAY_PANEL_HZ 175 // panel refresh with SETDISPLAYCLOCKDIV 0x80, 370kHz/(66 clocks*32 rows)
+// smallest divide ratio that gets the panel to GRAY_SUBFRAME_HZ or below: 2 -> 87.5Hz
+// subframes, a 29Hz cycle. Both from the datasheet's typical oscillator, the real one is +-15%
+#define GRAY_CLOCK_DIV ((GRAY_PANEL_HZ + GRAY_SUBFRAME_HZ - 1) / GRAY_SUBFRAME_HZ)
+#if GRAY_CLOCK_DIV < 1 || GRAY_CLOCK_DIV > 16
+#error "SETDISPLAYCLOCKDIV divides by 1 to 16"
+#endif
+#define GRAY_SLOW_LIMIT 6 // slow subframes in a row before falling back to 1 bit
+
+#define GRAY_MODE_4LEVEL 0
+#define GRAY_MODE_1BPP 1
+
+void gray_setup(void); // start in 4 level mode and tune the panel refresh
+void gray_clear(void);
+void gray_drawPixel(unsigned char x, unsigned char y, unsigned char level); // level 0-3
+void gray_drawMessage(unsigned char x, unsigned char y, char * arr, unsigned char level);
+void gray_refresh(void); // call as often as possible, sends the next subframe when it is due
+int gray_mode(void); // GRAY_MODE_4LEVEL or GRAY_MODE_1BPP
+unsigned int gray_pushTicks(void); // core timer ticks used by the last subframe push
+
+#endif
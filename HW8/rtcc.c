@@ -2,6 +2,9 @@
 #include<sys/attribs.h>  // __ISR macro
 #include "rtcc.h"
 #include "ssd1306.h"
+#include "gray.h"
+
+#define GRAY_DEMO 0 // 1 to show 4 gray bars and the measured subframe push time instead of the clock
 
 // DEVCFG0
 #pragma config DEBUG = OFF // disable debugging
@@ -59,9 +62,43 @@ int main() {
     char message[200];
     char day[8];
     int count=0;
+
+    if (GRAY_DEMO) {
+        // level 0 to 3 bars under two lines of text: the longest subframe push of the last
+        // half second against the time the subframe is on the panel, and the mode it ended in
+        unsigned int worst = 0;
+        unsigned int shown = _CP0_GET_COUNT();
+        int x, y;
+        gray_setup();
+        for (x = 0; x < 128; x++) {
+            for (y = 16; y < 32; y++) {
+                gray_drawPixel(x, y, x / 32);
+            }
+        }
+        while (1) {
+            gray_refresh();
+            if (gray_pushTicks() > worst) {
+                worst = gray_pushTicks();
+            }
+            if (_CP0_GET_COUNT() - shown > 24000000/2) {
+                shown = _CP0_GET_COUNT();
+                sprintf(message, "push %5dus of %5dus", worst / 24, 1000000 / GRAY_PANEL_HZ * GRAY_CLOCK_DIV);
+                gray_drawMessage(0, 0, message, 3);
+                gray_drawMessage(0, 8, gray_mode() == GRAY_MODE_4LEVEL ? "4 level      " : "1 bit, slow  ", 3);
+                worst = 0;
+            }
+        }
+    }
     //Set up time to the core
     rtcc_setup(0x20123000,0x20060700);
     rtccTime mytime;
+    //Text fields only redraw the characters that changed since the last frame
+    textField countField;
+    textField timeField;
+    textField dateField;
+    textField_init(&countField, 0, 0, 25);
+    textField_init(&timeField, 4, 8, 24);
+    textField_init(&dateField, 4, 16, 30);
     while (1) {
         _CP0_SET_COUNT(0);
         //Read time from core   
@@ -70,16 +107,17 @@ int main() {
         dayOfTheWeek(mytime.wk, day); 
         //update refreshed frame times
         sprintf(message, "Hi!  %d", count);        
-        drawMessage(0, 0, message);
+        textField_set(&countField, message);
         //Update TIME
         sprintf(message, "Current Time: %d%d:%d%d:%d%d", mytime.hr10, mytime.hr01, mytime.min10, mytime.min01, mytime.sec10, mytime.sec01);
-        drawMessage(4, 8, message);
+        textField_set(&timeField, message);
         //Update DATE        
         sprintf(message, "Date: %s, %d%d/%d%d/20%d%d", day, mytime.mn10, mytime.mn01, mytime.dy10, mytime.dy01, mytime.yr10, mytime.yr01);
-        drawMessage(4, 16, message);
+        textField_set(&dateField, message);
         //Set 2Hz update rate
         while(_CP0_GET_COUNT() < 24000000/2){}
-        ssd1306_update();
+        //Only send the columns that changed
+        ssd1306_updateDirty();
         //Update display at 2Hz
         count+=1;
     }